@@ -10,13 +10,19 @@ public:
   {
     cameraSpeed = 64.0f;
 
+    // Each octave adds a full noise pass per chunk, 3 keep generation close to the cost of a single unvectorized octave
     Lotus::PerlinNoiseConfig noiseConfiguration;
-    dataGenerator = std::make_shared<Lotus::ProceduralDataGenerator>(512, 6, noiseConfiguration);
+    noiseConfiguration.octaves = 3;
+    dataGenerator = std::make_shared<Lotus::ProceduralDataGenerator>(threadPool, 512, 6, noiseConfiguration, Lotus::ProceduralDataFormat::RUnsigned16);
+    dataGenerator->setAsynchronousLoading(true);
 
     setBackgroundColor(glm::vec3(0.5, 0.4, 0.4));
 
     renderingServer.setAmbientLight(glm::vec3(0.33, 0.33, 0.33));
 
+    // Thousands of placed objects, stored with quantized vertices to cut their memory and bandwidth
+    renderingServer.setObjectVertexFormat(Lotus::VertexFormat::Compact);
+
     createDirectionalLight();
     createPointLights();
     createTerrain();
@@ -64,8 +70,13 @@ private:
   {
     std::shared_ptr<Lotus::Mesh> rockAMesh = meshManager.loadMesh(Lotus::assetPath("models/nature/obj/rock_a.obj"));
     std::shared_ptr<Lotus::Mesh> rockBMesh = meshManager.loadMesh(Lotus::assetPath("models/nature/obj/rock_b.obj"));
-    std::shared_ptr<Lotus::Mesh> treeAMesh = meshManager.loadMesh(Lotus::assetPath("models/nature/obj/tree_a_green.obj"));
-    std::shared_ptr<Lotus::Mesh> treeBMesh = meshManager.loadMesh(Lotus::assetPath("models/nature/obj/tree_b_green.obj"));
+
+    // Distant trees are drawn with simplified versions of their meshes
+    Lotus::MeshManager::LoadOptions treeLoadOptions;
+    treeLoadOptions.simplifiedLODs = { { 0.5f, 150.0f }, { 0.2f, 400.0f } };
+
+    std::shared_ptr<Lotus::Mesh> treeAMesh = meshManager.loadMesh(Lotus::assetPath("models/nature/obj/tree_a_green.obj"), treeLoadOptions);
+    std::shared_ptr<Lotus::Mesh> treeBMesh = meshManager.loadMesh(Lotus::assetPath("models/nature/obj/tree_b_green.obj"), treeLoadOptions);
     
     std::shared_ptr<Lotus::DiffuseFlatMaterial> rockMaterial = std::static_pointer_cast<Lotus::DiffuseFlatMaterial>(renderingServer.createMaterial(Lotus::MaterialType::DiffuseFlat));
     std::shared_ptr<Lotus::DiffuseFlatMaterial> lightTreeMaterial = std::static_pointer_cast<Lotus::DiffuseFlatMaterial>(renderingServer.createMaterial(Lotus::MaterialType::DiffuseFlat));
@@ -6,6 +6,7 @@
 #include <imgui.h>
 #include "math/types.h"
 #include "util/log.h"
+#include "util/thread_pool.h"
 #include "util/window_entry.h"
 
 namespace Lotus
@@ -37,6 +38,9 @@ namespace Lotus
 
     std::string vendor;
     std::string device;
+
+    // Workers shared by every subsystem of the engine, so they never run more threads than there are cores
+    ThreadPool threadPool;
   };
 
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "types.h"
+
+namespace Lotus
+{
+
+  /*
+    Axis aligned bounding box
+  */
+  struct AABB
+  {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+    bool isValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+
+    glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+    glm::vec3 getExtents() const { return (max - min) * 0.5f; }
+
+    void expand(const glm::vec3& point)
+    {
+      min = glm::min(min, point);
+      max = glm::max(max, point);
+    }
+  };
+
+  /*
+    Bounding sphere
+  */
+  struct BoundingSphere
+  {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    // Sphere that encloses this one after being transformed by the given model matrix
+    BoundingSphere transform(const glm::mat4& model) const
+    {
+      BoundingSphere transformed;
+      transformed.center = glm::vec3(model * glm::vec4(center, 1.0f));
+
+      // The radius is scaled by the largest axis scale of the model matrix
+      float maxScale2 = std::max({
+          glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+          glm::dot(glm::vec3(model[1]), glm::vec3(model[1])),
+          glm::dot(glm::vec3(model[2]), glm::vec3(model[2])) });
+
+      transformed.radius = radius * std::sqrt(maxScale2);
+
+      return transformed;
+    }
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "types.h"
+#include "bounds.h"
+
+namespace Lotus
+{
+
+  /*
+    View frustum represented by six planes (ax + by + cz + d = 0) pointing inwards
+  */
+  struct Frustum
+  {
+    enum Plane
+    {
+      Left,
+      Right,
+      Bottom,
+      Top,
+      Near,
+      Far,
+      PlaneCount
+    };
+
+    Frustum() = default;
+
+    // Source: Gribb & Hartmann, Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix
+    Frustum(const glm::mat4& viewProjection)
+    {
+      glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+      glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+      glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+      glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+      planes[Left]   = row3 + row0;
+      planes[Right]  = row3 - row0;
+      planes[Bottom] = row3 + row1;
+      planes[Top]    = row3 - row1;
+      planes[Near]   = row3 + row2;
+      planes[Far]    = row3 - row2;
+
+      for (glm::vec4& plane : planes)
+      {
+        plane /= glm::length(glm::vec3(plane));
+      }
+    }
+
+    bool intersectsSphere(const glm::vec3& center, float radius) const
+    {
+      for (const glm::vec4& plane : planes)
+      {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+        {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    bool intersectsSphere(const BoundingSphere& sphere) const
+    {
+      return intersectsSphere(sphere.center, sphere.radius);
+    }
+
+    glm::vec4 planes[PlaneCount];
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "types.h"
+#include "simd.h"
+
+namespace Lotus
+{
+
+  /*
+    Batched composition of model matrices (translation * rotation * scale) from packed transform arrays.
+    The rotation is expanded straight from the quaternion with the scale folded into its columns, so no
+    intermediate matrix products are needed, and SIMDLanes::Width objects are composed at once
+  */
+  class ModelMatrixKernel
+  {
+  public:
+
+    // Calls output(index, model) for every index in [indices, indices + count)
+    template <typename Output>
+    static void compose(
+        const glm::vec3* translations,
+        const glm::fquat* rotations,
+        const glm::vec3* scales,
+        const uint32_t* indices,
+        size_t count,
+        Output&& output)
+    {
+      size_t i = 0;
+
+      for (; i + SIMDLanes::Width <= count; i += SIMDLanes::Width)
+      {
+        composeLanes<SIMDLanes>(translations, rotations, scales, indices + i, output);
+      }
+      for (; i < count; i++)
+      {
+        composeLanes<ScalarLanes>(translations, rotations, scales, indices + i, output);
+      }
+    }
+
+    static glm::mat4 compose(const glm::vec3& translation, const glm::fquat& rotation, const glm::vec3& scale)
+    {
+      glm::mat4 model;
+      const uint32_t index = 0;
+
+      auto output = [&model](uint32_t, const glm::mat4& result) { model = result; };
+
+      composeLanes<ScalarLanes>(&translation, &rotation, &scale, &index, output);
+
+      return model;
+    }
+
+  private:
+
+    // Same expansion as glm::mat3_cast, the quaternion is expected to be normalized
+    template <class Lanes, typename Output>
+    static void composeLanes(
+        const glm::vec3* translations,
+        const glm::fquat* rotations,
+        const glm::vec3* scales,
+        const uint32_t* indices,
+        Output& output)
+    {
+      using Float = typename Lanes::Float;
+
+      constexpr int Width = Lanes::Width;
+
+      // Objects are scattered through the arrays, so lanes are gathered into components first
+      float qx[Width], qy[Width], qz[Width], qw[Width];
+      float sx[Width], sy[Width], sz[Width];
+
+      for (int lane = 0; lane < Width; lane++)
+      {
+        const glm::fquat& rotation = rotations[indices[lane]];
+        const glm::vec3& scale = scales[indices[lane]];
+
+        qx[lane] = rotation.x;
+        qy[lane] = rotation.y;
+        qz[lane] = rotation.z;
+        qw[lane] = rotation.w;
+        sx[lane] = scale.x;
+        sy[lane] = scale.y;
+        sz[lane] = scale.z;
+      }
+
+      const Float x = Lanes::load(qx);
+      const Float y = Lanes::load(qy);
+      const Float z = Lanes::load(qz);
+      const Float w = Lanes::load(qw);
+
+      const Float one = Lanes::set(1.0f);
+      const Float two = Lanes::set(2.0f);
+
+      const Float xx = Lanes::mul(x, x);
+      const Float yy = Lanes::mul(y, y);
+      const Float zz = Lanes::mul(z, z);
+      const Float xy = Lanes::mul(x, y);
+      const Float xz = Lanes::mul(x, z);
+      const Float yz = Lanes::mul(y, z);
+      const Float wx = Lanes::mul(w, x);
+      const Float wy = Lanes::mul(w, y);
+      const Float wz = Lanes::mul(w, z);
+
+      const Float scaleX = Lanes::load(sx);
+      const Float scaleY = Lanes::load(sy);
+      const Float scaleZ = Lanes::load(sz);
+
+      // Columns of the rotation matrix, each one multiplied by its axis scale
+      float columns[9][Width];
+
+      Lanes::store(columns[0], Lanes::mul(Lanes::sub(one, Lanes::mul(two, Lanes::add(yy, zz))), scaleX));
+      Lanes::store(columns[1], Lanes::mul(Lanes::mul(two, Lanes::add(xy, wz)), scaleX));
+      Lanes::store(columns[2], Lanes::mul(Lanes::mul(two, Lanes::sub(xz, wy)), scaleX));
+
+      Lanes::store(columns[3], Lanes::mul(Lanes::mul(two, Lanes::sub(xy, wz)), scaleY));
+      Lanes::store(columns[4], Lanes::mul(Lanes::sub(one, Lanes::mul(two, Lanes::add(xx, zz))), scaleY));
+      Lanes::store(columns[5], Lanes::mul(Lanes::mul(two, Lanes::add(yz, wx)), scaleY));
+
+      Lanes::store(columns[6], Lanes::mul(Lanes::mul(two, Lanes::add(xz, wy)), scaleZ));
+      Lanes::store(columns[7], Lanes::mul(Lanes::mul(two, Lanes::sub(yz, wx)), scaleZ));
+      Lanes::store(columns[8], Lanes::mul(Lanes::sub(one, Lanes::mul(two, Lanes::add(xx, yy))), scaleZ));
+
+      for (int lane = 0; lane < Width; lane++)
+      {
+        const glm::vec3& translation = translations[indices[lane]];
+
+        output(indices[lane], glm::mat4(
+            glm::vec4(columns[0][lane], columns[1][lane], columns[2][lane], 0.0f),
+            glm::vec4(columns[3][lane], columns[4][lane], columns[5][lane], 0.0f),
+            glm::vec4(columns[6][lane], columns[7][lane], columns[8][lane], 0.0f),
+            glm::vec4(translation, 1.0f)));
+      }
+    }
+  };
+
+}
\ No newline at end of file
@@ -2,7 +2,11 @@
 
 #include <memory>
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
 #include "types.h"
+#include "simd.h"
 #include "PerlinNoise.hpp"
 
 namespace Lotus
@@ -30,20 +34,202 @@ namespace Lotus
       int octaves = std::clamp(noiseConfig.octaves, 1, 16);
 
       const siv::PerlinNoise perlin(noiseConfig.seed);
-      
+
+      const std::vector<uint8_t> latticeGradients = computeLatticeGradients(perlin);
+
+      // Corner gradients of the lattice row each octave is sampling, rebuilt only when the sampled row changes
+      std::vector<int32_t> cornerGradients(octaves * 256);
+      std::vector<int32_t> cornerGradientsRows(octaves, -1);
+
       const double fx = (frequency / width);
       const double fy = (frequency / height);
 
+      float maxAmplitude = 0.0f;
+      float amplitude = 1.0f;
+
+      for (int octave = 0; octave < octaves; octave++)
+      {
+        maxAmplitude += amplitude;
+        amplitude *= Persistence;
+      }
+
       for (int y = 0; y < height; ++y)
       {
-        for (int x = 0; x < width; ++x)
+        float* row = destination + y * width;
+
+        std::fill(row, row + width, 0.0f);
+
+        double octaveScale = 1.0;
+        amplitude = 1.0f;
+
+        for (int octave = 0; octave < octaves; octave++)
+        {
+          // Noise repeats every 256 units, wrapping in double precision keeps the float samples accurate for large offsets
+          const float xStart = wrap(noiseConfig.offset.x * fx * octaveScale);
+          const float xStep = static_cast<float>(fx * octaveScale);
+          const float ySample = wrap((y + noiseConfig.offset.y) * fy * octaveScale);
+          const int32_t latticeRow = static_cast<int32_t>(std::floor(ySample)) & 255;
+
+          int32_t* corners = cornerGradients.data() + octave * 256;
+
+          if (cornerGradientsRows[octave] != latticeRow)
+          {
+            computeCornerGradients(corners, latticeGradients, latticeRow);
+            cornerGradientsRows[octave] = latticeRow;
+          }
+
+          int x = 0;
+
+          for (; x + SIMDLanes::Width <= width; x += SIMDLanes::Width)
+          {
+            accumulateNoise<SIMDLanes>(row + x, x, xStart, xStep, ySample, amplitude, corners);
+          }
+          for (; x < width; x++)
+          {
+            accumulateNoise<ScalarLanes>(row + x, x, xStart, xStep, ySample, amplitude, corners);
+          }
+
+          octaveScale *= 2.0;
+          amplitude *= Persistence;
+        }
+
+        // Same normalization and remapping to [0, 1] as siv::PerlinNoise::normalizedOctave2D_01
+        int x = 0;
+
+        for (; x + SIMDLanes::Width <= width; x += SIMDLanes::Width)
+        {
+          normalize<SIMDLanes>(row + x, maxAmplitude);
+        }
+        for (; x < width; x++)
+        {
+          normalize<ScalarLanes>(row + x, maxAmplitude);
+        }
+      }
+    }
+
+  private:
+
+    static constexpr float Persistence = 0.5f;
+
+    /*
+      Gradients of the siv::PerlinNoise hash at every point of the 256x256 lattice, for the fixed z plane of noise2D.
+      The low 4 bits select the gradient of the lower z corner and the high 4 bits the one of the upper z corner
+    */
+    static std::vector<uint8_t> computeLatticeGradients(const siv::PerlinNoise& perlin)
+    {
+      const auto& permutation = perlin.serialize();
+      const int32_t z = static_cast<int32_t>(std::floor(static_cast<float>(SIVPERLIN_DEFAULT_Z))) & 255;
+
+      std::vector<uint8_t> gradients(256 * 256);
+
+      for (int32_t j = 0; j < 256; j++)
+      {
+        for (int32_t i = 0; i < 256; i++)
         {
-          float xSample = (x * fx) + noiseConfig.offset.x * fx;
-          float ySample = (y * fy) + noiseConfig.offset.y * fy;
+          const int32_t hash = (permutation[(permutation[i] + j) & 255] + z) & 255;
 
-          destination[y * width + x] = perlin.noise2D_01(xSample, ySample);
+          gradients[j * 256 + i] = static_cast<uint8_t>((permutation[hash] & 15) | ((permutation[(hash + 1) & 255] & 15) << 4));
         }
       }
+
+      return gradients;
+    }
+
+    // Packs the gradients of the 4 corners of every cell of a lattice row, so a sample needs a single lookup
+    static void computeCornerGradients(int32_t* corners, const std::vector<uint8_t>& latticeGradients, int32_t latticeRow)
+    {
+      const uint8_t* row = latticeGradients.data() + latticeRow * 256;
+      const uint8_t* nextRow = latticeGradients.data() + ((latticeRow + 1) & 255) * 256;
+
+      for (int32_t i = 0; i < 256; i++)
+      {
+        const int32_t next = (i + 1) & 255;
+
+        corners[i] = static_cast<int32_t>(row[i] | (row[next] << 8) | (nextRow[i] << 16) | (static_cast<uint32_t>(nextRow[next]) << 24));
+      }
+    }
+
+    static float wrap(double sample)
+    {
+      double wrapped = std::fmod(sample, 256.0);
+      return static_cast<float>(wrapped < 0.0 ? wrapped + 256.0 : wrapped);
+    }
+
+    template <class Lanes>
+    static typename Lanes::Float fade(typename Lanes::Float t)
+    {
+      // t * t * t * (t * (t * 6 - 15) + 10)
+      typename Lanes::Float polynomial = Lanes::add(Lanes::mul(t, Lanes::sub(Lanes::mul(t, Lanes::set(6.0f)), Lanes::set(15.0f))), Lanes::set(10.0f));
+      return Lanes::mul(Lanes::mul(Lanes::mul(t, t), t), polynomial);
+    }
+
+    template <class Lanes>
+    static typename Lanes::Float lerp(typename Lanes::Float a, typename Lanes::Float b, typename Lanes::Float t)
+    {
+      return Lanes::add(a, Lanes::mul(Lanes::sub(b, a), t));
+    }
+
+    // Vectorized siv::PerlinNoise::noise2D, which samples 3D noise at a fixed z, see computeLatticeGradients
+    template <class Lanes>
+    static void accumulateNoise(float* destination, int x, float xStart, float xStep, float ySample, float amplitude, const int32_t* corners)
+    {
+      using Float = typename Lanes::Float;
+      using Int = typename Lanes::Int;
+
+      const Float xSample = Lanes::add(Lanes::set(xStart), Lanes::mul(Lanes::add(Lanes::set(static_cast<float>(x)), Lanes::ramp()), Lanes::set(xStep)));
+
+      const float yFloor = std::floor(ySample);
+      const float zSample = static_cast<float>(SIVPERLIN_DEFAULT_Z);
+      const float zFloor = std::floor(zSample);
+
+      const Float xFloor = Lanes::floor(xSample);
+
+      const Int ix = Lanes::andInt(Lanes::toInt(xFloor), Lanes::setInt(255));
+
+      const Float fx = Lanes::sub(xSample, xFloor);
+      const Float fy = Lanes::set(ySample - yFloor);
+      const Float fz = Lanes::set(zSample - zFloor);
+      const Float fxMinusOne = Lanes::sub(fx, Lanes::set(1.0f));
+      const Float fyMinusOne = Lanes::sub(fy, Lanes::set(1.0f));
+      const Float fzMinusOne = Lanes::sub(fz, Lanes::set(1.0f));
+
+      const Float u = fade<Lanes>(fx);
+      const Float v = fade<Lanes>(fy);
+      const Float w = fade<Lanes>(fz);
+
+      // Gradients of the 8 corners of the cell, 4 bits each, the gradient function only reads the lowest 4
+      const Int gradients = Lanes::gather(corners, ix);
+
+      const Float p0 = Lanes::gradient(gradients, fx, fy, fz);
+      const Float p1 = Lanes::gradient(Lanes::shiftRightInt(gradients, 8), fxMinusOne, fy, fz);
+      const Float p2 = Lanes::gradient(Lanes::shiftRightInt(gradients, 16), fx, fyMinusOne, fz);
+      const Float p3 = Lanes::gradient(Lanes::shiftRightInt(gradients, 24), fxMinusOne, fyMinusOne, fz);
+      const Float p4 = Lanes::gradient(Lanes::shiftRightInt(gradients, 4), fx, fy, fzMinusOne);
+      const Float p5 = Lanes::gradient(Lanes::shiftRightInt(gradients, 12), fxMinusOne, fy, fzMinusOne);
+      const Float p6 = Lanes::gradient(Lanes::shiftRightInt(gradients, 20), fx, fyMinusOne, fzMinusOne);
+      const Float p7 = Lanes::gradient(Lanes::shiftRightInt(gradients, 28), fxMinusOne, fyMinusOne, fzMinusOne);
+
+      const Float q0 = lerp<Lanes>(p0, p1, u);
+      const Float q1 = lerp<Lanes>(p2, p3, u);
+      const Float q2 = lerp<Lanes>(p4, p5, u);
+      const Float q3 = lerp<Lanes>(p6, p7, u);
+
+      const Float r0 = lerp<Lanes>(q0, q1, v);
+      const Float r1 = lerp<Lanes>(q2, q3, v);
+
+      const Float noise = lerp<Lanes>(r0, r1, w);
+
+      Lanes::store(destination, Lanes::add(Lanes::load(destination), Lanes::mul(noise, Lanes::set(amplitude))));
+    }
+
+    template <class Lanes>
+    static void normalize(float* destination, float maxAmplitude)
+    {
+      typename Lanes::Float value = Lanes::mul(Lanes::load(destination), Lanes::set(0.5f / maxAmplitude));
+      value = Lanes::add(value, Lanes::set(0.5f));
+      value = Lanes::min(Lanes::max(value, Lanes::set(0.0f)), Lanes::set(1.0f));
+
+      Lanes::store(destination, value);
     }
   };
 
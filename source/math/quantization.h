@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <bit>
+#include "types.h"
+
+namespace Lotus
+{
+
+  // Maps [0, 1] to the full range of a 16 bit unsigned normalized value, as GL_R16 does
+  inline uint16_t quantizeUnorm16(float value)
+  {
+    return static_cast<uint16_t>(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+  }
+
+  inline float dequantizeUnorm16(uint16_t value)
+  {
+    return value / 65535.0f;
+  }
+
+  // Maps [-1, 1] to a 16 bit signed normalized value, as GL_SHORT attributes with normalization read it
+  inline int16_t quantizeSnorm16(float value)
+  {
+    return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+  }
+
+  // Both -32768 and -32767 are -1, as in OpenGL
+  inline float dequantizeSnorm16(int16_t value)
+  {
+    return std::max(value / 32767.0f, -1.0f);
+  }
+
+  // IEEE 754 half precision float, rounded to the nearest even value as GL_HALF_FLOAT expects
+  inline uint16_t quantizeHalf(float value)
+  {
+    uint32_t bits = std::bit_cast<uint32_t>(value);
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    bits &= 0x7FFFFFFF;
+
+    // NaN stays a quiet NaN
+    if (bits > 0x7F800000)
+    {
+      return sign | 0x7E00;
+    }
+
+    // Values from the midpoint between the largest half (65504) and the next representable value are infinity
+    if (bits >= 0x477FF000)
+    {
+      return sign | 0x7C00;
+    }
+
+    // Below 2^-14 halves are subnormal, with a fixed step of 2^-24
+    if (bits < 0x38800000)
+    {
+      return sign | static_cast<uint16_t>(std::nearbyint(std::bit_cast<float>(bits) * 16777216.0f));
+    }
+
+    // Exponent rebiased from 127 to 15 and mantissa rounded from 23 to 10 bits
+    const uint32_t rounding = 0xFFF + ((bits >> 13) & 1);
+
+    return sign | static_cast<uint16_t>((bits - 0x38000000 + rounding) >> 13);
+  }
+
+  inline float dequantizeHalf(uint16_t value)
+  {
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1F;
+    const uint32_t mantissa = value & 0x3FF;
+
+    if (exponent == 0)
+    {
+      const float subnormal = mantissa / 16777216.0f;
+      return sign ? -subnormal : subnormal;
+    }
+
+    if (exponent == 0x1F)
+    {
+      return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+    }
+
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+  }
+
+  /*
+    Unit vector mapped to [-1, 1]^2 by projecting it on an octahedron, whose lower half is folded over the upper one.
+    Source: Cigolle et al., A Survey of Efficient Representations for Independent Unit Vectors
+  */
+  inline glm::vec2 encodeOctahedral(const glm::vec3& direction)
+  {
+    const float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+
+    if (length <= 0.0f)
+    {
+      return glm::vec2(0.0f);
+    }
+
+    glm::vec2 encoded = glm::vec2(direction.x, direction.y) / length;
+
+    if (direction.z < 0.0f)
+    {
+      encoded = glm::vec2(
+          (1.0f - std::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f),
+          (1.0f - std::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f));
+    }
+
+    return encoded;
+  }
+
+  inline glm::vec3 decodeOctahedral(const glm::vec2& encoded)
+  {
+    glm::vec3 direction(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+
+    // Points of the folded lower half are moved back towards their own quadrant
+    const float fold = std::max(-direction.z, 0.0f);
+    direction.x += direction.x >= 0.0f ? -fold : fold;
+    direction.y += direction.y >= 0.0f ? -fold : fold;
+
+    return glm::normalize(direction);
+  }
+
+}
\ No newline at end of file
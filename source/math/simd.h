@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+#if defined(LOTUS_SIMD_AVX2) || defined(__AVX2__)
+  #define LOTUS_AVX2 1
+  #include <immintrin.h>
+#elif defined(LOTUS_SIMD_SSE4) || defined(__SSE4_1__) || defined(__AVX__)
+  #define LOTUS_SSE4 1
+  #include <smmintrin.h>
+#endif
+
+namespace Lotus
+{
+
+  /*
+    Thin wrappers over the instruction set selected at compile time, so kernels can be
+    written once as templates over the lane operations. ScalarLanes is always available
+    and is used for the fallback and for the remainder of the batched loops
+  */
+  struct ScalarLanes
+  {
+    using Float = float;
+    using Int = int32_t;
+
+    static constexpr int Width = 1;
+
+    static Float set(float value) { return value; }
+    static Int setInt(int32_t value) { return value; }
+    static Float ramp() { return 0.0f; }
+
+    static Float load(const float* source) { return *source; }
+    static void store(float* destination, Float value) { *destination = value; }
+
+    static Float add(Float a, Float b) { return a + b; }
+    static Float sub(Float a, Float b) { return a - b; }
+    static Float mul(Float a, Float b) { return a * b; }
+    static Float min(Float a, Float b) { return a < b ? a : b; }
+    static Float max(Float a, Float b) { return a > b ? a : b; }
+    static Float floor(Float a) { return std::floor(a); }
+
+    static Int toInt(Float a) { return static_cast<int32_t>(a); }
+    static Int addInt(Int a, Int b) { return a + b; }
+    static Int andInt(Int a, Int b) { return a & b; }
+    static Int shiftRightInt(Int a, int bits) { return static_cast<int32_t>(static_cast<uint32_t>(a) >> bits); }
+    static Int gather(const int32_t* table, Int index) { return table[index]; }
+
+    // Same gradient selection as Ken Perlin's improved noise reference implementation
+    static Float gradient(Int hash, Float x, Float y, Float z)
+    {
+      const int32_t h = hash & 15;
+      const float u = h < 8 ? x : y;
+      const float v = h < 4 ? y : h == 12 || h == 14 ? x : z;
+      return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+    }
+  };
+
+#if LOTUS_AVX2
+
+  struct SIMDLanes
+  {
+    using Float = __m256;
+    using Int = __m256i;
+
+    static constexpr int Width = 8;
+
+    static Float set(float value) { return _mm256_set1_ps(value); }
+    static Int setInt(int32_t value) { return _mm256_set1_epi32(value); }
+    static Float ramp() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+
+    static Float load(const float* source) { return _mm256_loadu_ps(source); }
+    static void store(float* destination, Float value) { _mm256_storeu_ps(destination, value); }
+
+    static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+    static Float min(Float a, Float b) { return _mm256_min_ps(a, b); }
+    static Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+    static Float floor(Float a) { return _mm256_floor_ps(a); }
+
+    static Int toInt(Float a) { return _mm256_cvttps_epi32(a); }
+    static Int addInt(Int a, Int b) { return _mm256_add_epi32(a, b); }
+    static Int andInt(Int a, Int b) { return _mm256_and_si256(a, b); }
+    static Int shiftRightInt(Int a, int bits) { return _mm256_srli_epi32(a, bits); }
+    static Int gather(const int32_t* table, Int index) { return _mm256_i32gather_epi32(table, index, 4); }
+
+    static Float gradient(Int hash, Float x, Float y, Float z)
+    {
+      const __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+
+      const __m256i lessThan8 = _mm256_cmpgt_epi32(_mm256_set1_epi32(8), h);
+      const __m256i lessThan4 = _mm256_cmpgt_epi32(_mm256_set1_epi32(4), h);
+      const __m256i is12Or14 = _mm256_or_si256(_mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)), _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14)));
+
+      __m256 u = _mm256_blendv_ps(y, x, _mm256_castsi256_ps(lessThan8));
+      __m256 v = _mm256_blendv_ps(_mm256_blendv_ps(z, x, _mm256_castsi256_ps(is12Or14)), y, _mm256_castsi256_ps(lessThan4));
+
+      // Bits 0 and 1 of the hash flip the sign of u and v
+      const __m256i uSign = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31);
+      const __m256i vSign = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30);
+
+      u = _mm256_xor_ps(u, _mm256_castsi256_ps(uSign));
+      v = _mm256_xor_ps(v, _mm256_castsi256_ps(vSign));
+
+      return _mm256_add_ps(u, v);
+    }
+  };
+
+#elif LOTUS_SSE4
+
+  struct SIMDLanes
+  {
+    using Float = __m128;
+    using Int = __m128i;
+
+    static constexpr int Width = 4;
+
+    static Float set(float value) { return _mm_set1_ps(value); }
+    static Int setInt(int32_t value) { return _mm_set1_epi32(value); }
+    static Float ramp() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+
+    static Float load(const float* source) { return _mm_loadu_ps(source); }
+    static void store(float* destination, Float value) { _mm_storeu_ps(destination, value); }
+
+    static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+    static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+    static Float min(Float a, Float b) { return _mm_min_ps(a, b); }
+    static Float max(Float a, Float b) { return _mm_max_ps(a, b); }
+    static Float floor(Float a) { return _mm_floor_ps(a); }
+
+    static Int toInt(Float a) { return _mm_cvttps_epi32(a); }
+    static Int addInt(Int a, Int b) { return _mm_add_epi32(a, b); }
+    static Int andInt(Int a, Int b) { return _mm_and_si128(a, b); }
+    static Int shiftRightInt(Int a, int bits) { return _mm_srli_epi32(a, bits); }
+
+    // There is no gather before AVX2, so lanes are looked up one by one
+    static Int gather(const int32_t* table, Int index)
+    {
+      return _mm_setr_epi32(
+          table[_mm_extract_epi32(index, 0)],
+          table[_mm_extract_epi32(index, 1)],
+          table[_mm_extract_epi32(index, 2)],
+          table[_mm_extract_epi32(index, 3)]);
+    }
+
+    static Float gradient(Int hash, Float x, Float y, Float z)
+    {
+      const __m128i h = _mm_and_si128(hash, _mm_set1_epi32(15));
+
+      const __m128i lessThan8 = _mm_cmplt_epi32(h, _mm_set1_epi32(8));
+      const __m128i lessThan4 = _mm_cmplt_epi32(h, _mm_set1_epi32(4));
+      const __m128i is12Or14 = _mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14)));
+
+      __m128 u = _mm_blendv_ps(y, x, _mm_castsi128_ps(lessThan8));
+      __m128 v = _mm_blendv_ps(_mm_blendv_ps(z, x, _mm_castsi128_ps(is12Or14)), y, _mm_castsi128_ps(lessThan4));
+
+      // Bits 0 and 1 of the hash flip the sign of u and v
+      const __m128i uSign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31);
+      const __m128i vSign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30);
+
+      u = _mm_xor_ps(u, _mm_castsi128_ps(uSign));
+      v = _mm_xor_ps(v, _mm_castsi128_ps(vSign));
+
+      return _mm_add_ps(u, v);
+    }
+  };
+
+#else
+
+  using SIMDLanes = ScalarLanes;
+
+#endif
+
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <limits>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -15,6 +16,8 @@ namespace Lotus
   template <typename T>
   struct Handler
   {
+    static constexpr uint32_t InvalidHandle = std::numeric_limits<uint32_t>::max();
+
     uint32_t handle = 0;
   };
 
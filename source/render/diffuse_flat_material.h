@@ -24,7 +24,7 @@ namespace Lotus
       }
 
       diffuseColor = color;
-      dirty = true;
+      markDirty();
     }
 
     virtual void setMaterialUniforms() override
@@ -32,7 +32,7 @@ namespace Lotus
       }
 
       diffuseTexture = texture;
-      dirty = true;
+      markDirty();
     }
     
     void setDiffuseTextureTint(const glm::vec3& tint)
@@ -44,7 +44,7 @@ namespace Lotus
       }
 
       diffuseTextureTint = tint;
-      dirty = true;
+      markDirty();
     }
     
     virtual void setMaterialUniforms() override
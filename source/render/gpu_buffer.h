@@ -6,24 +6,59 @@
 #include <algorithm>
 #include <vector>
 #include <set>
+#include <type_traits>
 #include "../util/log.h"
+#include "../util/block_allocator.h"
 #include "../util/opengl_entry.h"
 #include "../math/types.h"
 #include "gpu_structures.h"
 #include "mesh.h"
+#include "vertex_layout.h"
 
 namespace Lotus
 {
 
-  template <typename T, bool CPUMapEnabled = true>
+  /*
+    Strategies used to write the contents of a GPU buffer from the CPU
+  */
+  enum class GPUBufferMapping
+  {
+    CPUShadow,  // Writes go to a CPU copy of the buffer, uploaded on unmap
+    Driver,     // Writes go to the memory returned by the driver on every map
+    Persistent  // Writes go straight to a persistently mapped ring of regions, one per frame in flight, see GPUBuffer::flush
+  };
+
+  struct BufferRange
+  {
+    uint32_t first;
+    size_t size;
+  };
+
+  template <typename T, GPUBufferMapping Mapping = GPUBufferMapping::CPUShadow>
   struct GPUBuffer
   {
+    static constexpr uint32_t PersistentRegionsCount = 3;
+    static constexpr uint64_t PersistentFenceTimeout = 1000000; // 1 ms
+
+    // Dirty ranges closer than this amount of elements are written together, as the gap costs less than another call
+    static constexpr size_t CoalescingGap = std::max<size_t>(1, 256 / sizeof(T));
+
     GPUBuffer() :
       ID(0),
       bufferType(GL_SHADER_STORAGE_BUFFER),
       filledSize(0),
       allocatedSize(0),
-      allocated(false)
+      minimumAllocationSize(0),
+      allocated(false),
+      persistentData(nullptr),
+      regionStride(0),
+      committedRegion(0),
+      writeRegion(0),
+      copySourceRegion(0),
+      regionOpen(false),
+      regionFlushed(false),
+      copiedFromSource(false),
+      fences{}
     {
       glGenBuffers(1, &ID);
       
@@ -36,11 +71,16 @@ namespace Lotus
     {
       glDeleteBuffers(1, &ID);
 
-      if constexpr(CPUMapEnabled)
+      if constexpr(Mapping == GPUBufferMapping::CPUShadow)
       {
         delete[] CPUBuffer;
       }
 
+      if constexpr(Mapping == GPUBufferMapping::Persistent)
+      {
+        releaseFences();
+      }
+
       LOTUS_LOG_INFO("[Buffer Log] Deleted buffer with ID {0}", ID);
     }
 
@@ -66,16 +106,24 @@ namespace Lotus
         return;
       }
 
-      glBindBuffer(bufferType, ID);
-      glBufferData(bufferType, initialAllocationSize * sizeof(T), nullptr, GL_DYNAMIC_DRAW);
-      glBindBuffer(bufferType, 0);
+      if constexpr(Mapping == GPUBufferMapping::Persistent)
+      {
+        allocatePersistentStorage(ID, initialAllocationSize);
+      }
+      else
+      {
+        glBindBuffer(bufferType, ID);
+        glBufferData(bufferType, initialAllocationSize * sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(bufferType, 0);
+      }
 
-      if constexpr(CPUMapEnabled)
+      if constexpr(Mapping == GPUBufferMapping::CPUShadow)
       {
         CPUBuffer = new T[initialAllocationSize];
       }
       
       allocatedSize = initialAllocationSize;
+      minimumAllocationSize = initialAllocationSize;
       allocated = true;
 
       LOTUS_LOG_INFO("[Buffer Log] Allocated buffer with ID {0} (Size = {1})", ID, initialAllocationSize);
@@ -89,11 +137,23 @@ namespace Lotus
         return;
       }
 
-      glBindBuffer(bufferType, ID);
-      glBufferData(bufferType, initialAllocationSize * sizeof(T), initialAllocationData, GL_DYNAMIC_DRAW);
-      glBindBuffer(bufferType, 0);
+      if constexpr(Mapping == GPUBufferMapping::Persistent)
+      {
+        allocatePersistentStorage(ID, initialAllocationSize);
+
+        for (uint32_t region = 0; region < PersistentRegionsCount; region++)
+        {
+          std::memcpy(getRegionData(region), initialAllocationData, initialAllocationSize * sizeof(T));
+        }
+      }
+      else
+      {
+        glBindBuffer(bufferType, ID);
+        glBufferData(bufferType, initialAllocationSize * sizeof(T), initialAllocationData, GL_DYNAMIC_DRAW);
+        glBindBuffer(bufferType, 0);
+      }
 
-      if constexpr(CPUMapEnabled)
+      if constexpr(Mapping == GPUBufferMapping::CPUShadow)
       {
         CPUBuffer = new T[initialAllocationSize];
 
@@ -101,11 +161,57 @@ namespace Lotus
       }
       
       allocatedSize = initialAllocationSize;
+      minimumAllocationSize = initialAllocationSize;
       allocated = true;
 
       LOTUS_LOG_INFO("[Buffer Log] Allocated buffer with ID {0} (Size = {1})", ID, initialAllocationSize);
     }
 
+    // Frees the storage, the buffer can be allocated again afterwards
+    void release()
+    {
+      if (!allocated)
+      {
+        return;
+      }
+
+      glDeleteBuffers(1, &ID);
+
+      LOTUS_LOG_INFO("[Buffer Log] Released buffer with ID {0}", ID);
+
+      glGenBuffers(1, &ID);
+
+      if constexpr(Mapping == GPUBufferMapping::CPUShadow)
+      {
+        delete[] CPUBuffer;
+        CPUBuffer = nullptr;
+      }
+
+      if constexpr(Mapping == GPUBufferMapping::Persistent)
+      {
+        releaseFences();
+
+        persistentData = nullptr;
+        committedRegion = 0;
+        writeRegion = 0;
+        regionOpen = false;
+        regionFlushed = false;
+        writtenRanges.clear();
+
+        for (std::vector<BufferRange>& ranges : pendingRanges)
+        {
+          ranges.clear();
+        }
+      }
+
+      dirtyRanges.clear();
+
+      filledSize = 0;
+      allocatedSize = 0;
+      minimumAllocationSize = 0;
+      allocated = false;
+    }
+
     void reallocate(size_t size)
     {
       if (!allocated)
@@ -124,22 +230,30 @@ namespace Lotus
       uint32_t newID;
 
       glGenBuffers(1, &newID);
-      glBindBuffer(bufferType, newID);
-      glBufferData(bufferType, newAllocationSize * sizeof(T), nullptr, GL_DYNAMIC_DRAW);
 
-      glBindBuffer(GL_COPY_READ_BUFFER, ID);
+      if constexpr(Mapping != GPUBufferMapping::Persistent)
+      {
+        glBindBuffer(bufferType, newID);
+        glBufferData(bufferType, newAllocationSize * sizeof(T), nullptr, GL_DYNAMIC_DRAW);
 
-      glCopyBufferSubData(GL_COPY_READ_BUFFER, bufferType, 0, 0, std::min(allocatedSize, newAllocationSize) * sizeof(T));
+        glBindBuffer(GL_COPY_READ_BUFFER, ID);
 
-      glBindBuffer(bufferType, 0);
-      glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, bufferType, 0, 0, std::min(allocatedSize, newAllocationSize) * sizeof(T));
+
+        glBindBuffer(bufferType, 0);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+      }
+      else
+      {
+        reallocatePersistentStorage(newID, newAllocationSize);
+      }
 
       glDeleteBuffers(1, &ID);
 
-      if constexpr(CPUMapEnabled)
+      if constexpr(Mapping == GPUBufferMapping::CPUShadow)
       {
         T* newCPUBuffer = new T[newAllocationSize];
-        std::memcpy(newCPUBuffer, CPUBuffer, allocatedSize * sizeof(T));
+        std::memcpy(newCPUBuffer, CPUBuffer, std::min(allocatedSize, newAllocationSize) * sizeof(T));
 
         delete[] CPUBuffer;
 
@@ -166,17 +280,29 @@ namespace Lotus
 
     void write(const T* source, uint32_t first, size_t size)
     {
-      glBindBuffer(bufferType, ID);
-      glBufferSubData(bufferType, first * sizeof(T), size * sizeof(T), source);
-      glBindBuffer(bufferType, 0);
+      if constexpr(Mapping == GPUBufferMapping::Persistent)
+      {
+        std::memcpy(openWriteRegion() + first, source, size * sizeof(T));
+        writtenRanges.push_back({ first, size });
+      }
+      else
+      {
+        glBindBuffer(bufferType, ID);
+        glBufferSubData(bufferType, first * sizeof(T), size * sizeof(T), source);
+        glBindBuffer(bufferType, 0);
+      }
     }
 
     T* map()
     {
-      if constexpr(CPUMapEnabled)
+      if constexpr(Mapping == GPUBufferMapping::CPUShadow)
       {
         return CPUBuffer;
       }
+      else if constexpr(Mapping == GPUBufferMapping::Persistent)
+      {
+        return openWriteRegion();
+      }
       else
       {
         return (T*) (glMapNamedBuffer(ID, GL_WRITE_ONLY));
@@ -185,9 +311,14 @@ namespace Lotus
 
     void unmap()
     {
-      if constexpr(CPUMapEnabled)
+      if constexpr(Mapping == GPUBufferMapping::CPUShadow)
       {
-        write(CPUBuffer, 0, filledSize);
+        uploadDirtyRanges();
+      }
+      else if constexpr(Mapping == GPUBufferMapping::Persistent)
+      {
+        writtenRanges.insert(writtenRanges.end(), dirtyRanges.begin(), dirtyRanges.end());
+        dirtyRanges.clear();
       }
       else
       {
@@ -195,18 +326,387 @@ namespace Lotus
       }
     }
 
+    // Elements written through map() have to be reported, only those are uploaded, or brought up to date in the other persistent regions
+    void markDirty(uint32_t first, size_t size = 1)
+    {
+      if constexpr(Mapping != GPUBufferMapping::Driver)
+      {
+        dirtyRanges.push_back({ first, size });
+      }
+    }
+
+    // Byte offset of the region the GPU has to read in the current frame
+    size_t getRegionOffset() const
+    {
+      if constexpr(Mapping == GPUBufferMapping::Persistent)
+      {
+        return (regionOpen ? writeRegion : committedRegion) * regionStride;
+      }
+      else
+      {
+        return 0;
+      }
+    }
+
+    /*
+      Must be called once the writes of the current frame are done, before the commands reading the buffer are issued.
+      The elements written since the region was last used are copied on the GPU from the previous region, except the
+      ones written in this frame, which the copies would overwrite as they run after the writes
+    */
+    void flush()
+    {
+      if constexpr(Mapping == GPUBufferMapping::Persistent)
+      {
+        if (!regionOpen || regionFlushed)
+        {
+          return;
+        }
+
+        writtenRanges.insert(writtenRanges.end(), dirtyRanges.begin(), dirtyRanges.end());
+        dirtyRanges.clear();
+
+        // Merged without gaps, as the elements between two written ranges must still be copied
+        coalesceRanges(writtenRanges, 0);
+        coalesceRanges(pendingRanges[writeRegion]);
+
+        std::vector<BufferRange> copiedRanges = subtractRanges(pendingRanges[writeRegion], writtenRanges);
+
+        if (!copiedRanges.empty())
+        {
+          glBindBuffer(GL_COPY_READ_BUFFER, ID);
+          glBindBuffer(GL_COPY_WRITE_BUFFER, ID);
+
+          for (const BufferRange& range : copiedRanges)
+          {
+            if (range.first >= allocatedSize)
+            {
+              break;
+            }
+
+            size_t size = std::min(range.size, allocatedSize - range.first);
+
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, committedRegion * regionStride + range.first * sizeof(T), writeRegion * regionStride + range.first * sizeof(T), size * sizeof(T));
+          }
+
+          glBindBuffer(GL_COPY_READ_BUFFER, 0);
+          glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+          copySourceRegion = committedRegion;
+          copiedFromSource = true;
+        }
+
+        pendingRanges[writeRegion].clear();
+        regionFlushed = true;
+      }
+    }
+
+    // Must be called once the commands reading the buffer in the current frame were issued
+    void fence()
+    {
+      if constexpr(Mapping == GPUBufferMapping::Persistent)
+      {
+        if (regionOpen)
+        {
+          // The region committed by this frame is the source of the next copies, so it must be up to date even if it wasn't flushed
+          flush();
+
+          committedRegion = writeRegion;
+          regionOpen = false;
+          regionFlushed = false;
+
+          for (uint32_t region = 0; region < PersistentRegionsCount; region++)
+          {
+            if (region != committedRegion)
+            {
+              pendingRanges[region].insert(pendingRanges[region].end(), writtenRanges.begin(), writtenRanges.end());
+            }
+          }
+
+          writtenRanges.clear();
+        }
+
+        // The copies of this frame read the previous region, which can't be written again before they are done
+        if (copiedFromSource)
+        {
+          resetFence(copySourceRegion);
+          copiedFromSource = false;
+        }
+
+        resetFence(committedRegion);
+      }
+    }
+
     uint32_t ID;
     uint32_t bufferType;
     size_t filledSize;
     size_t allocatedSize;
+    size_t minimumAllocationSize;
     bool allocated;
 
     // TODO: Declare this variable at compile time (not possible with if constexpr)
     T* CPUBuffer;
+
+  private:
+
+    // Sorts the ranges and merges the overlapping or close ones, so they are written with the least amount of calls
+    static void coalesceRanges(std::vector<BufferRange>& ranges, size_t gap = CoalescingGap)
+    {
+      if (ranges.size() < 2)
+      {
+        return;
+      }
+
+      std::sort(ranges.begin(), ranges.end(), [](const BufferRange& a, const BufferRange& b) { return a.first < b.first; });
+
+      size_t last = 0;
+
+      for (size_t i = 1; i < ranges.size(); i++)
+      {
+        BufferRange& lastRange = ranges[last];
+        const BufferRange& range = ranges[i];
+
+        if (range.first <= lastRange.first + lastRange.size + gap)
+        {
+          lastRange.size = std::max(lastRange.first + lastRange.size, range.first + range.size) - lastRange.first;
+        }
+        else
+        {
+          ranges[++last] = range;
+        }
+      }
+
+      ranges.resize(last + 1);
+    }
+
+    void uploadDirtyRanges()
+    {
+      if (dirtyRanges.empty())
+      {
+        return;
+      }
+
+      coalesceRanges(dirtyRanges);
+
+      glBindBuffer(bufferType, ID);
+
+      for (const BufferRange& range : dirtyRanges)
+      {
+        if (range.first >= allocatedSize)
+        {
+          break;
+        }
+
+        size_t size = std::min(range.size, allocatedSize - range.first);
+
+        glBufferSubData(bufferType, range.first * sizeof(T), size * sizeof(T), CPUBuffer + range.first);
+      }
+
+      glBindBuffer(bufferType, 0);
+
+      dirtyRanges.clear();
+    }
+
+    // Parts of the ranges not covered by the removed ones, both sorted and without overlaps
+    static std::vector<BufferRange> subtractRanges(const std::vector<BufferRange>& ranges, const std::vector<BufferRange>& removedRanges)
+    {
+      std::vector<BufferRange> result;
+
+      size_t removed = 0;
+
+      for (const BufferRange& range : ranges)
+      {
+        size_t first = range.first;
+        const size_t end = range.first + range.size;
+
+        while (removed < removedRanges.size() && removedRanges[removed].first + removedRanges[removed].size <= first)
+        {
+          removed++;
+        }
+
+        for (size_t i = removed; i < removedRanges.size() && removedRanges[i].first < end; i++)
+        {
+          if (removedRanges[i].first > first)
+          {
+            result.push_back({ static_cast<uint32_t>(first), removedRanges[i].first - first });
+          }
+
+          first = std::max<size_t>(first, removedRanges[i].first + removedRanges[i].size);
+        }
+
+        if (first < end)
+        {
+          result.push_back({ static_cast<uint32_t>(first), end - first });
+        }
+      }
+
+      return result;
+    }
+
+    T* getRegionData(uint32_t region)
+    {
+      return reinterpret_cast<T*>(persistentData + region * regionStride);
+    }
+
+    void allocatePersistentStorage(uint32_t bufferID, size_t size)
+    {
+      // Regions are bound as ranges, so each one starts at an offset valid for any buffer binding
+      GLint alignment = 1;
+      glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+      alignment = std::max(alignment, 1);
+
+      regionStride = (size * sizeof(T) + alignment - 1) / alignment * alignment;
+
+      // Write only, reading back mapped memory is uncached and would stall on every access
+      const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+      glBindBuffer(bufferType, bufferID);
+      glBufferStorage(bufferType, regionStride * PersistentRegionsCount, nullptr, flags);
+      persistentData = static_cast<uint8_t*>(glMapBufferRange(bufferType, 0, regionStride * PersistentRegionsCount, flags));
+      glBindBuffer(bufferType, 0);
+    }
+
+    void reallocatePersistentStorage(uint32_t newID, size_t newAllocationSize)
+    {
+      const size_t copiedSize = std::min(allocatedSize, newAllocationSize);
+      const size_t oldRegionStride = regionStride;
+
+      allocatePersistentStorage(newID, newAllocationSize);
+
+      // The first region receives the committed region, then the elements already written in the open one
+      glBindBuffer(GL_COPY_READ_BUFFER, ID);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, newID);
+
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, committedRegion * oldRegionStride, 0, copiedSize * sizeof(T));
+
+      if (regionOpen)
+      {
+        writtenRanges.insert(writtenRanges.end(), dirtyRanges.begin(), dirtyRanges.end());
+        dirtyRanges.clear();
+
+        coalesceRanges(writtenRanges, 0);
+
+        for (const BufferRange& range : writtenRanges)
+        {
+          if (range.first >= copiedSize)
+          {
+            break;
+          }
+
+          size_t size = std::min(range.size, copiedSize - range.first);
+
+          glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, writeRegion * oldRegionStride + range.first * sizeof(T), range.first * sizeof(T), size * sizeof(T));
+        }
+      }
+
+      glBindBuffer(GL_COPY_READ_BUFFER, 0);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+      releaseFences();
+
+      fences[0] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+      // The next writes of an open region would be overwritten by the copies still running, reallocations are rare enough to wait for them
+      if (regionOpen)
+      {
+        waitRegion(0);
+      }
+
+      // The first region is up to date and stays open if it was, the other ones are refreshed from it when they are reused
+      committedRegion = 0;
+      writeRegion = 0;
+      regionFlushed = false;
+      copiedFromSource = false;
+
+      for (uint32_t region = 1; region < PersistentRegionsCount; region++)
+      {
+        pendingRanges[region].assign(1, { 0, copiedSize });
+      }
+
+      pendingRanges[0].clear();
+    }
+
+    T* openWriteRegion()
+    {
+      if (!regionOpen)
+      {
+        writeRegion = (committedRegion + 1) % PersistentRegionsCount;
+
+        waitRegion(writeRegion);
+
+        regionOpen = true;
+      }
+      else if (regionFlushed)
+      {
+        LOTUS_LOG_WARN("[Buffer Warning] Wrote buffer with ID {0} after it was flushed, the copies of the frame may overwrite the writes", ID);
+      }
+
+      return getRegionData(writeRegion);
+    }
+
+    void waitRegion(uint32_t region)
+    {
+      if (!fences[region])
+      {
+        return;
+      }
+
+      GLenum status = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, PersistentFenceTimeout);
+
+      while (status == GL_TIMEOUT_EXPIRED)
+      {
+        status = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, PersistentFenceTimeout);
+      }
+
+      if (status == GL_WAIT_FAILED)
+      {
+        LOTUS_LOG_WARN("[Buffer Warning] Failed to wait for the GPU to release a region of buffer with ID {0}", ID);
+      }
+
+      glDeleteSync(fences[region]);
+      fences[region] = nullptr;
+    }
+
+    void resetFence(uint32_t region)
+    {
+      if (fences[region])
+      {
+        glDeleteSync(fences[region]);
+      }
+
+      fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    void releaseFences()
+    {
+      for (GLsync& fence : fences)
+      {
+        if (fence)
+        {
+          glDeleteSync(fence);
+          fence = nullptr;
+        }
+      }
+    }
+
+    /* Dirty tracking */
+    std::vector<BufferRange> dirtyRanges;
+
+    /* Persistent mapping */
+    uint8_t* persistentData;
+    size_t regionStride;
+    uint32_t committedRegion;
+    uint32_t writeRegion;
+    uint32_t copySourceRegion;
+    bool regionOpen;
+    bool regionFlushed;
+    bool copiedFromSource;
+    GLsync fences[PersistentRegionsCount];
+    std::vector<BufferRange> writtenRanges;
+    std::vector<BufferRange> pendingRanges[PersistentRegionsCount];
   };
 
-  template <typename T, bool CPUMapEnabled = true>
-  struct SingleElementGPUBuffer : GPUBuffer<T, CPUMapEnabled>
+  template <typename T, GPUBufferMapping Mapping = GPUBufferMapping::CPUShadow>
+  struct SingleElementGPUBuffer : GPUBuffer<T, Mapping>
   {
     uint32_t add(const T* source)
     {
@@ -230,7 +730,7 @@ namespace Lotus
 
       this->write(source, first, 1);
 
-      if constexpr(CPUMapEnabled)
+      if constexpr(Mapping == GPUBufferMapping::CPUShadow)
       {
         this->CPUBuffer[first] = *source;
       }
@@ -249,36 +749,29 @@ namespace Lotus
         LOTUS_LOG_WARN("[Buffer Warning] Tried to remove element outside buffer scope, buffer ID {0}", this->ID);
         return;
       }
+
+      // Free places at the end of the buffer are trimmed, so the filled size follows the live elements
+      while (!allocationPlaces.empty() && *allocationPlaces.rbegin() == this->filledSize - 1)
+      {
+        allocationPlaces.erase(std::prev(allocationPlaces.end()));
+        this->filledSize--;
+      }
     }
 
     std::set<uint32_t> allocationPlaces;
   };
 
   template <typename T>
-  struct MultiElementGPUBuffer : GPUBuffer<T, false>
+  struct MultiElementGPUBuffer : GPUBuffer<T, GPUBufferMapping::Driver>
   {
     uint32_t add(const T* source, size_t size = 1)
     {
-      uint32_t first = this->filledSize;
+      uint32_t first = allocator.allocate(size);
 
-      for (int i = 0; i < allocationBlocks.size(); i++)
+      if (first == BlockAllocator::InvalidOffset)
       {
-        int sizeDifference = allocationBlocks[i].size - size;
-
-        if (sizeDifference == 0)
-        {
-          first = allocationBlocks[i].first;
-          allocationBlocks[i] = allocationBlocks.back();
-          allocationBlocks.pop_back();
-          break;
-        }
-        else if (sizeDifference > 0)
-        {
-          first = allocationBlocks[i].first;
-          allocationBlocks[i].first += size;
-          allocationBlocks[i].size = sizeDifference;
-          break;
-        }
+        LOTUS_LOG_WARN("[Buffer Warning] Tried to add an empty block, buffer ID {0}", this->ID);
+        return first;
       }
 
       if (first + size > this->allocatedSize)
@@ -286,131 +779,150 @@ namespace Lotus
         this->reallocate(first + size);
       }
 
-      if (first + size > this->filledSize)
-      {
-        this->filledSize = first + size;
-      }
+      this->filledSize = allocator.getEnd();
 
       this->write(source, first, size);
 
       return first;
     }
 
-    void remove(uint32_t first, size_t size = 1)
+    void release()
     {
-      int previousAllocationBlockIndex = -1;
-      int nextAllocationBlockIndex = -1;
+      GPUBuffer<T, GPUBufferMapping::Driver>::release();
 
-      int i = 0;
-      
-      while (i < allocationBlocks.size())
+      allocator = BlockAllocator();
+    }
+
+    void remove(uint32_t first, size_t size = 1)
+    {
+      if (!allocator.free(first, size))
       {
-        AllocationBlock& block = allocationBlocks[i];
+        LOTUS_LOG_WARN("[Buffer Warning] Tried to remove block outside the buffer or inside a free region, buffer ID {0}", this->ID);
+        return;
+      }
 
-        if (block.first <= first && (block.first + block.size) >= first + size)
-        {
-          LOTUS_LOG_WARN("[Buffer Warning] Tried to remove block inside a free region, buffer ID {0}", this->ID);
-          return;
-        }
+      this->filledSize = allocator.getEnd();
+    }
 
-        if (block.first >= first && (block.first + block.size) <= first + size)
-        {
-          allocationBlocks[i] = allocationBlocks.back();
-          allocationBlocks.pop_back();
-          continue;
-        }
+    // Fraction of the filled size taken by free blocks
+    float getFragmentation() const
+    {
+      return allocator.getEnd() == 0 ? 0.0f : static_cast<float>(allocator.getFreeSize()) / allocator.getEnd();
+    }
 
-        if (block.first < first && (block.first + block.size) < first + size)
-        {
-          previousAllocationBlockIndex = i;
-        }
-        else if(block.first > first && (block.first + block.size) > first + size)
-        {
-          nextAllocationBlockIndex = i;
-        }
+    /*
+      Moves the live blocks to the beginning of a new buffer, which is shrunk while it's less than a quarter full.
+      The owners of the blocks must update their offsets with BlockAllocator::relocate and the returned moves
+    */
+    std::vector<BlockAllocator::Move> compact()
+    {
+      std::vector<BlockAllocator::Move> moves = allocator.compact();
+
+      size_t liveSize = allocator.getEnd();
+      size_t newAllocationSize = this->allocatedSize;
 
-        i++;
+      while (newAllocationSize / 2 >= this->minimumAllocationSize && newAllocationSize / 2 >= liveSize * 2)
+      {
+        newAllocationSize /= 2;
       }
 
-      int finalBlockIndex;
+      uint32_t newID;
 
-      if (previousAllocationBlockIndex != -1)
-      {
-        finalBlockIndex = previousAllocationBlockIndex;
+      glGenBuffers(1, &newID);
+      glBindBuffer(this->bufferType, newID);
+      glBufferData(this->bufferType, newAllocationSize * sizeof(T), nullptr, GL_DYNAMIC_DRAW);
 
-        AllocationBlock& prevBlock = allocationBlocks[previousAllocationBlockIndex];
+      glBindBuffer(GL_COPY_READ_BUFFER, this->ID);
 
-        prevBlock.size += first + size - (prevBlock.first + prevBlock.size);
-      }
-      else
+      // Source and destination are different buffers, so moved ranges may overlap their old place
+      for (const BlockAllocator::Move& move : moves)
       {
-        allocationBlocks.emplace_back(first, size);
-        finalBlockIndex = allocationBlocks.size() - 1;
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, this->bufferType, move.source * sizeof(T), move.destination * sizeof(T), move.size * sizeof(T));
       }
 
-      if (nextAllocationBlockIndex != -1)
-      {
-        AllocationBlock& finalBlock = allocationBlocks[finalBlockIndex];
-        AllocationBlock& nextBlock = allocationBlocks[nextAllocationBlockIndex];
+      glBindBuffer(this->bufferType, 0);
+      glBindBuffer(GL_COPY_READ_BUFFER, 0);
 
-        finalBlock.size = nextBlock.first + nextBlock.size - (finalBlock.first + finalBlock.size); 
+      glDeleteBuffers(1, &this->ID);
 
-        allocationBlocks[nextAllocationBlockIndex] = allocationBlocks.back();
-        allocationBlocks.pop_back();
-      }
-    }
+      LOTUS_LOG_INFO("[Buffer Log] Compacted buffer with ID {0} (Old ID = {1}, Size = {2}, Old Size = {3}, Filled Size = {4}, Old Filled Size = {5})", newID, this->ID, newAllocationSize, this->allocatedSize, liveSize, this->filledSize);
 
-    struct AllocationBlock
-    {
-      AllocationBlock(uint32_t initialFirst, size_t initialSize) :
-        first(initialFirst),
-        size(initialSize)
-      {}
+      this->ID = newID;
+      this->allocatedSize = newAllocationSize;
+      this->filledSize = liveSize;
 
-      uint32_t first;
-      size_t size;
-    };
+      this->link();
+
+      return moves;
+    }
 
-    std::vector<AllocationBlock> allocationBlocks;
+    BlockAllocator allocator;
   };
 
   /*
-    Buffer for meshes vertices
+    Buffer for meshes vertices, either MeshVertex or CompactVertex. Only the attributes read by the shaders
+    drawing from it are enabled in the vertex array, see VertexAttribute
   */
-  struct VertexBuffer : public MultiElementGPUBuffer<MeshVertex>
+  template <typename Vertex = MeshVertex>
+  struct VertexBuffer : public MultiElementGPUBuffer<Vertex>
   {
-    VertexBuffer() : vertexArray(0)
+    VertexBuffer() : vertexArray(0), attributes(AllVertexAttributes)
     {
-      bufferType = GL_ARRAY_BUFFER;
+      this->bufferType = GL_ARRAY_BUFFER;
     }
 
-    void setVertexArray(uint32_t newVertexArray)
+    void setVertexArray(uint32_t newVertexArray, uint32_t newAttributes = AllVertexAttributes)
     {
       vertexArray = newVertexArray;
+      attributes = newAttributes;
       link();
     }
 
     virtual void link() override
     {
       glBindVertexArray(vertexArray);
-      glBindBuffer(bufferType, ID);
+      glBindBuffer(this->bufferType, this->ID);
+
+      if constexpr(std::is_same_v<Vertex, CompactVertex>)
+      {
+        linkAttribute(0, 4, GL_SHORT, GL_TRUE, offsetof(CompactVertex, position), PositionAttribute);
+        linkAttribute(1, 2, GL_SHORT, GL_TRUE, offsetof(CompactVertex, normal), NormalAttribute);
+        linkAttribute(2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(CompactVertex, uv), UVAttribute);
+        linkAttribute(3, 2, GL_SHORT, GL_TRUE, offsetof(CompactVertex, tangent), TangentAttribute);
 
-      glEnableVertexAttribArray(0);
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*) offsetof(MeshVertex, position));
-      glEnableVertexAttribArray(1);
-      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*) offsetof(MeshVertex, normal));
-      glEnableVertexAttribArray(2);
-      glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*) offsetof(MeshVertex, uv));
-      glEnableVertexAttribArray(3);
-      glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*) offsetof(MeshVertex, tangent));
-      glEnableVertexAttribArray(4);
-      glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*) offsetof(MeshVertex, bitangent));
+        // The bitangent is derived from the normal, the tangent and the sign stored with the position
+        glDisableVertexAttribArray(4);
+      }
+      else
+      {
+        linkAttribute(0, 3, GL_FLOAT, GL_FALSE, offsetof(MeshVertex, position), PositionAttribute);
+        linkAttribute(1, 3, GL_FLOAT, GL_FALSE, offsetof(MeshVertex, normal), NormalAttribute);
+        linkAttribute(2, 2, GL_FLOAT, GL_FALSE, offsetof(MeshVertex, uv), UVAttribute);
+        linkAttribute(3, 3, GL_FLOAT, GL_FALSE, offsetof(MeshVertex, tangent), TangentAttribute);
+        linkAttribute(4, 3, GL_FLOAT, GL_FALSE, offsetof(MeshVertex, bitangent), TangentAttribute);
+      }
 
       glBindVertexArray(0);
-      glBindBuffer(bufferType, 0);
+      glBindBuffer(this->bufferType, 0);
     }
 
     uint32_t vertexArray;
+    uint32_t attributes;
+
+  private:
+
+    void linkAttribute(uint32_t location, int32_t size, uint32_t type, bool normalized, size_t offset, uint32_t attribute)
+    {
+      if (attributes & attribute)
+      {
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, size, type, normalized ? GL_TRUE : GL_FALSE, sizeof(Vertex), (void*) offset);
+      }
+      else
+      {
+        glDisableVertexAttribArray(location);
+      }
+    }
   };
 
   /*
@@ -443,19 +955,20 @@ namespace Lotus
   /*
     Buffer for draw commands
   */
-  struct DrawIndirectBuffer : public SingleElementGPUBuffer<DrawElementsIndirectCommand, true>
+  template <GPUBufferMapping Mapping = GPUBufferMapping::CPUShadow>
+  struct DrawIndirectBuffer : public SingleElementGPUBuffer<DrawElementsIndirectCommand, Mapping>
   {
     DrawIndirectBuffer()
     {
-      bufferType = GL_DRAW_INDIRECT_BUFFER;
+      this->bufferType = GL_DRAW_INDIRECT_BUFFER;
     }
   };
 
   /*
     Buffer for generic single-element storage
   */
-  template <typename T>
-  struct ShaderStorageBuffer : public SingleElementGPUBuffer<T, true>
+  template <typename T, GPUBufferMapping Mapping = GPUBufferMapping::CPUShadow>
+  struct ShaderStorageBuffer : public SingleElementGPUBuffer<T, Mapping>
   {
     ShaderStorageBuffer() : bindingPoint(0)
     {
@@ -464,13 +977,21 @@ namespace Lotus
 
     void setBindingPoint(uint32_t newBindingPoint)
     {
-      glBindBufferBase(this->bufferType, newBindingPoint, this->ID);
       bindingPoint = newBindingPoint;
+      bind();
     }
 
     virtual void bind() override
     {
-      glBindBufferBase(this->bufferType, bindingPoint, this->ID);
+      if constexpr(Mapping == GPUBufferMapping::Persistent)
+      {
+        // Only the region of the current frame is visible to the shaders
+        glBindBufferRange(this->bufferType, bindingPoint, this->ID, this->getRegionOffset(), this->allocatedSize * sizeof(T));
+      }
+      else
+      {
+        glBindBufferBase(this->bufferType, bindingPoint, this->ID);
+      }
     }
 
     virtual void unbind() override
@@ -21,7 +21,7 @@ namespace Lotus
 
   private:
     uint32_t vertexArrayID;
-    VertexBuffer vertexBuffer;
+    VertexBuffer<MeshVertex> vertexBuffer;
     IndexBuffer indexBuffer;
 
     uint32_t indicesCount;
@@ -13,6 +13,8 @@ namespace Lotus
         break;
       case TextureFormat::RUnsigned:
         return GL_R8;
+      case TextureFormat::RUnsigned16:
+        return GL_R16;
       case TextureFormat::RFloat:
         return GL_R32F;
       case TextureFormat::RGBUnsigned:
@@ -37,6 +39,7 @@ namespace Lotus
       case TextureFormat::Invalid:
         break;
       case TextureFormat::RUnsigned:
+      case TextureFormat::RUnsigned16:
       case TextureFormat::RFloat:
         return GL_RED;
       case TextureFormat::RGBUnsigned:
@@ -62,6 +65,8 @@ namespace Lotus
       case TextureFormat::RGBUnsigned:
       case TextureFormat::RGBAUnsigned:
         return GL_UNSIGNED_BYTE;
+      case TextureFormat::RUnsigned16:
+        return GL_UNSIGNED_SHORT;
       case TextureFormat::RFloat:
       case TextureFormat::RGBFloat:
       case TextureFormat::RGBAFloat:
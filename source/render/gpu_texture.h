@@ -8,6 +8,7 @@ namespace Lotus
   {
     Invalid,
     RUnsigned,
+    RUnsigned16,
     RFloat,
     RGBUnsigned,
     RGBFloat,
@@ -1,32 +1,37 @@
 #include "indirect_object_renderer.h"
 
 #include <algorithm>
+#include <limits>
 #include "../../util/log.h"
 #include "../../util/opengl_entry.h"
 #include "../../util/opengl_extensions.h"
 #include "../../util/profile.h"
 #include "../../util/path_manager.h"
+#include "../../util/radix_sort.h"
 #include "../identifiers.h"
 
 namespace Lotus {
 
-  IndirectObjectRenderer::IndirectObjectRenderer() : vertexArrayID(0), objectBatchesModified(false)
+  IndirectObjectRenderer::IndirectObjectRenderer(ThreadPool& engineThreadPool) :
+    vertexArrayID(0),
+    vertexFormat(VertexFormat::Full),
+    vertexAttributes(PositionAttribute),
+    objectsCount(0),
+    drawBatchesModified(false),
+    lodCameraPosition(std::numeric_limits<float>::max()),
+    lodRefreshDistance(std::numeric_limits<float>::max()),
+    frustumCullingEnabled(true),
+    visibilityRefreshRequired(false),
+    previousViewProjection(0.0f),
+    threadPool(engineThreadPool)
   {
     supportsTexturedMaterials = OpenGLExtensionChecker::isExtensionSupported(OpenGLExtension::BindlessTexture);
 
-    shaders[static_cast<unsigned int>(MaterialType::UnlitFlat)] = ShaderProgram(shaderPath("indirect/unlit_flat.vert"), shaderPath("indirect/unlit_flat.frag"));
-    shaders[static_cast<unsigned int>(MaterialType::DiffuseFlat)] = ShaderProgram(shaderPath("indirect/diffuse_flat.vert"), shaderPath("indirect/diffuse_flat.frag"));
-
-    if (supportsTexturedMaterials)
-    {
-      shaders[static_cast<unsigned int>(MaterialType::DiffuseTextured)] = ShaderProgram(shaderPath("indirect/diffuse_textured.vert"), shaderPath("indirect/diffuse_textured.frag"));
-    }
+    loadShaders();
 
     glGenVertexArrays(1, &vertexArrayID);
 
-    vertexBuffer.allocate(VertexBufferInitialAllocationSize);
-    vertexBuffer.setVertexArray(vertexArrayID);
-
+    // The vertex buffer is allocated with the first mesh, once its format can't change anymore
     indexBuffer.allocate(IndexBufferInitialAllocationSize);
     indexBuffer.setVertexArray(vertexArrayID);
 
@@ -52,49 +57,124 @@ namespace Lotus {
     }
   }
 
-  std::shared_ptr<MeshObject> IndirectObjectRenderer::createObject(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material)
+  std::shared_ptr<MeshObject> IndirectObjectRenderer::createObject(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material)
   {
     LOTUS_PROFILE_INCREASE_COUNTER(FrameCounter::AddedIndirectObjects);
 
-    std::shared_ptr<MeshObject> object = std::make_shared<MeshObject>(mesh, material);
-    objects.push_back(object);
-
-    Handler<IndirectRenderMesh> meshHandler = getMeshHandler(mesh);
-    Handler<IndirectRenderMaterial> materialHandler = getMaterialHandler(material);
+    Handler<IndirectRenderMesh> meshHandler = acquireMeshHandler(mesh);
+    Handler<IndirectRenderMaterial> materialHandler = acquireMaterialHandler(material);
 
-    glm::mat4 model = object->getModelMatrix();
+    // New objects start with the identity transform
+    glm::mat4 model(1.0f);
 
     GPUObjectData GPUObject;
-    GPUObject.model = model;
-    GPUObject.materialHandle = materialHandler.handle;
+    GPUObject.model = renderMeshes[meshHandler.handle].quantization.getModelMatrix(model);
+    GPUObject.materialHandle = renderMaterials[materialHandler.handle].ID;
       
     uint32_t objectID = objectBuffer.add(&GPUObject);
 
+    objectStore.initialize(objectID, mesh, material);
+
+    std::shared_ptr<MeshObject> object = std::make_shared<MeshObject>(&objectStore, objectID, RenderingMethod::Indirect);
+
     IndirectRenderObject renderObject;
     renderObject.model = model;
     renderObject.mesh = meshHandler;
+    renderObject.lodMesh = meshHandler;
     renderObject.material = materialHandler;
     renderObject.shader.handle = static_cast<uint32_t>(material->getType());
     renderObject.ID = objectID;
-    
-    Handler<IndirectRenderObject> handler(static_cast<uint32_t>(renderObjects.size()));
-    renderObjects.push_back(renderObject);
+    updateBoundingSphere(renderObject);
+
+    // Objects are indexed by their GPU buffer place, so freed places are reused by new objects
+    Handler<IndirectRenderObject> handler(objectID);
+
+    if (objectID < renderObjects.size())
+    {
+      objects[objectID] = object;
+      renderObjects[objectID] = renderObject;
+    }
+    else
+    {
+      objects.push_back(object);
+      renderObjects.push_back(renderObject);
+    }
+
+    objectsCount++;
 
     unbatchedObjectsHandlers.push_back(handler);
 
     return object;
   }
 
-  void IndirectObjectRenderer::render()
+  void IndirectObjectRenderer::destroyObject(const std::shared_ptr<MeshObject>& object)
+  {
+    uint32_t handle = object->rendererHandle;
+
+    if (handle >= objects.size() || objects[handle] != object)
+    {
+      LOTUS_LOG_WARN("[Indirect Renderer Warning] Tried to destroy object that does not belong to the renderer");
+      return;
+    }
+
+    IndirectRenderObject& renderObject = renderObjects[handle];
+
+    if (renderObject.unbatched)
+    {
+      // The object was created after the last batch build, so it only has to leave the queue
+      auto it = std::find_if(unbatchedObjectsHandlers.begin(), unbatchedObjectsHandlers.end(),
+          [handle](const Handler<IndirectRenderObject>& handler) { return handler.handle == handle; });
+
+      if (it != unbatchedObjectsHandlers.end())
+      {
+        *it = unbatchedObjectsHandlers.back();
+        unbatchedObjectsHandlers.pop_back();
+      }
+    }
+    else
+    {
+      unbatchObject(renderObject);
+    }
+
+    renderObject.unbatched = false;
+
+    objectBuffer.remove(renderObject.ID);
+
+    releaseMeshHandler(renderObject.mesh);
+    releaseMaterialHandler(renderObject.material);
+
+    objectStore.release(handle);
+    object->store = nullptr;
+
+    objects[handle] = nullptr;
+    objectsCount--;
+
+    // Trailing free places were trimmed by the buffer, the CPU side arrays follow it
+    objects.resize(objectBuffer.filledSize);
+    renderObjects.resize(objectBuffer.filledSize);
+    objectStore.resize(objectBuffer.filledSize);
+  }
+
+  void IndirectObjectRenderer::render(const Camera& camera)
   {
     update();
 
+    updateLODs(camera);
+
     buildBatches();
 
+    cullObjects(camera);
+
     refreshBuffers();
 
     LOTUS_PROFILE_START_TIME(FrameTime::IndirectSceneRenderTime);
 
+    // The elements written in previous frames are copied to the regions read by this frame before the draws
+    indirectBuffer.flush();
+    objectBuffer.flush();
+    objectHandleBuffer.flush();
+    materialBuffer.flush();
+
     glBindVertexArray(vertexArrayID);
     
     indirectBuffer.bind();
@@ -111,11 +191,17 @@ namespace Lotus {
       glMultiDrawElementsIndirect(
           GL_TRIANGLES,
           GL_UNSIGNED_INT,
-          (void*) (shaderBatch.first * sizeof(DrawElementsIndirectCommand)),
+          (void*) (indirectBuffer.getRegionOffset() + shaderBatch.first * sizeof(DrawElementsIndirectCommand)),
           shaderBatch.count,
           sizeof(DrawElementsIndirectCommand));
     }
 
+    // The regions read by this frame can't be written again until the GPU is done with them
+    indirectBuffer.fence();
+    objectBuffer.fence();
+    objectHandleBuffer.fence();
+    materialBuffer.fence();
+
     materialBuffer.unbind();
     objectBuffer.unbind();
     objectHandleBuffer.unbind();
@@ -126,61 +212,160 @@ namespace Lotus {
     LOTUS_PROFILE_END_TIME(FrameTime::IndirectSceneRenderTime);
   }
 
+  void IndirectObjectRenderer::setFrustumCullingEnabled(bool enabled)
+  {
+    if (enabled == frustumCullingEnabled)
+    {
+      return;
+    }
+
+    frustumCullingEnabled = enabled;
+    visibilityRefreshRequired = true;
+  }
+
+  void IndirectObjectRenderer::setVertexFormat(VertexFormat format)
+  {
+    if (format == vertexFormat)
+    {
+      return;
+    }
+
+    // Meshes already stored would have to be converted and their objects rewritten
+    if (meshes.size() > freeMeshesHandlers.size())
+    {
+      LOTUS_LOG_WARN("[Indirect Renderer Warning] Tried to change the vertex format while there are meshes loaded");
+      return;
+    }
+
+    // Only evicted meshes used the buffer of the previous format
+    if (vertexFormat == VertexFormat::Compact)
+    {
+      compactVertexBuffer.release();
+    }
+    else
+    {
+      vertexBuffer.release();
+    }
+
+    vertexFormat = format;
+
+    loadShaders();
+  }
+
   void IndirectObjectRenderer::update()
   {
     updateObjects();
     updateMaterials();
+
+    const float vertexFragmentation = vertexFormat == VertexFormat::Compact ? compactVertexBuffer.getFragmentation() : vertexBuffer.getFragmentation();
+
+    // Holes left by removed meshes are packed once they take too much of the mesh buffers
+    if (vertexFragmentation > MeshBufferFragmentationLimit || indexBuffer.getFragmentation() > MeshBufferFragmentationLimit)
+    {
+      compactMeshBuffers();
+    }
+  }
+
+  void IndirectObjectRenderer::compactMeshBuffers()
+  {
+    std::vector<BlockAllocator::Move> vertexMoves = vertexFormat == VertexFormat::Compact ? compactVertexBuffer.compact() : vertexBuffer.compact();
+    std::vector<BlockAllocator::Move> indexMoves = indexBuffer.compact();
+
+    for (int i = 0; i < renderMeshes.size(); i++)
+    {
+      // Evicted meshes don't own any range anymore
+      if (meshes[i] == nullptr)
+      {
+        continue;
+      }
+
+      IndirectRenderMesh& renderMesh = renderMeshes[i];
+
+      renderMesh.baseVertex = BlockAllocator::relocate(vertexMoves, renderMesh.baseVertex);
+      renderMesh.firstIndex = BlockAllocator::relocate(indexMoves, renderMesh.firstIndex);
+    }
+
+    // Draw commands hold the old mesh offsets
+    visibilityRefreshRequired = true;
   }
 
   void IndirectObjectRenderer::updateObjects()
   {
     LOTUS_PROFILE_START_TIME(FrameTime::IndirectObjectUpdateTime);
 
-    for (int i = 0; i < objects.size(); i++)
+    objectStore.consumeDirty([this](uint32_t i, uint8_t flags)
     {
-      const std::shared_ptr<MeshObject>& object = objects[i];
-      Transform* transform = &(object->transform);
+      IndirectRenderObject& renderObject = renderObjects[i];
+      Handler<IndirectRenderObject> objectHandle(i);
 
-      if (transform->dirty || object->meshDirty || object->materialDirty)
+      if (flags & ObjectStore::MaterialDirty)
       {
-        IndirectRenderObject& renderObject = renderObjects[i];
-        Handler<IndirectRenderObject> objectHandle(i);
+        Handler<IndirectRenderMaterial> previousMaterial = renderObject.material;
 
-        if (transform->dirty)
+        renderObject.material = acquireMaterialHandler(objectStore.materials[i]);
+        releaseMaterialHandler(previousMaterial);
+      }
+      if (flags & (ObjectStore::MeshDirty | ObjectStore::ShaderDirty))
+      {
+        if (!renderObject.unbatched)
         {
-          renderObject.model = object->getModelMatrix();
-          transform->dirty = false;
+          /*
+            The renderer MUST rearrange the batch related to this object if the mesh or the shader change
+            so the batches ordering logic works accordingly.
+          */
+          unbatchObject(renderObject);
+          unbatchedObjectsHandlers.push_back(objectHandle);
+
+          renderObject.unbatched = true;
         }
-        if (object->materialDirty)
+
+        Handler<IndirectRenderMesh> previousMesh = renderObject.mesh;
+
+        renderObject.mesh = acquireMeshHandler(objectStore.meshes[i]);
+        renderObject.lodMesh = renderObject.mesh;
+        releaseMeshHandler(previousMesh);
+
+        renderObject.shader.handle = static_cast<uint32_t>(objectStore.materials[i]->getType());
+      }
+
+      // Moved objects get their bounding sphere along with their model matrix
+      if (flags & ObjectStore::TransformDirty)
+      {
+        movedObjectsHandlers.push_back(i);
+
+        // Only the draw batch of the object has to be culled again
+        if (frustumCullingEnabled && !renderObject.unbatched)
         {
-          renderObject.material = getMaterialHandler(object->getMaterial());
-          object->materialDirty = false;
+          findDrawBatch(renderObject.shader, renderObject.lodMesh)->dirty = true;
         }
-        if (object->meshDirty || object->shaderDirty)
-        {
-          if (!renderObject.unbatched)
-          {
-            /*
-              The renderer MUST rearrange the batch related to this object if the mesh or the shader change
-              so the batches ordering logic works accordingly.
-            */
-            toUnbatchObjects.push_back(renderObject);
-            unbatchedObjectsHandlers.push_back(objectHandle);
-
-            renderObject.unbatched = true;
-          }
+      }
+      else
+      {
+        updateBoundingSphere(renderObject);
+      }
 
-          renderObject.mesh = getMeshHandler(object->getMesh());
-          renderObject.shader.handle = static_cast<uint32_t>(object->getMaterial()->getType());
-          
-          object->meshDirty = false;
-          object->shaderDirty = false;
-        }
+      // Queue the object to be updated in the GPU buffer
+      dirtyObjectsHandlers.push_back(objectHandle);
+    });
 
-        // Queue the object to be updated in the GPU buffer
-        dirtyObjectsHandlers.push_back(objectHandle);
-      }
-    }
+    // Every object is written by a single batch, so the batches can run on the workers without locking
+    const uint32_t batchesCount = (movedObjectsHandlers.size() + ModelMatrixBatchSize - 1) / ModelMatrixBatchSize;
+
+    threadPool.parallelFor(batchesCount, [this](uint32_t batch)
+    {
+      const size_t first = batch * ModelMatrixBatchSize;
+      const size_t count = std::min<size_t>(ModelMatrixBatchSize, movedObjectsHandlers.size() - first);
+
+      objectStore.computeModelMatrices(movedObjectsHandlers.data() + first, count, [this](uint32_t i, const glm::mat4& model)
+      {
+        IndirectRenderObject& renderObject = renderObjects[i];
+
+        renderObject.model = model;
+        updateBoundingSphere(renderObject);
+      });
+    });
+
+    movedObjectsHandlers.clear();
 
     LOTUS_PROFILE_END_TIME(FrameTime::IndirectObjectUpdateTime);
   }
@@ -189,167 +374,163 @@ namespace Lotus {
   {
     LOTUS_PROFILE_START_TIME(FrameTime::IndirectMaterialUpdateTime);
 
-    for (int i = 0; i < materials.size(); i++)
+    // Materials used by the renderer queue themselves when they change
+    for (uint32_t resourceID : dirtyMaterialsQueue)
     {
-      const std::shared_ptr<Material>& material = materials[i];
+      Handler<IndirectRenderMaterial> materialHandle = materialMap[resourceID];
 
-      if (material->dirty)
+      if (materialHandle.handle == Handler<IndirectRenderMaterial>::InvalidHandle)
       {
-        IndirectRenderMaterial& renderMaterial= renderMaterials[i];
-        Handler<IndirectRenderMaterial> materialHandle(i);
+        continue;
+      }
+
+      const std::shared_ptr<Material>& material = materials[materialHandle.handle];
 
+      if (material->dirty)
+      {
         material->dirty = false;
 
         dirtyMaterialsHandlers.push_back(materialHandle);
       }
     }
 
+    dirtyMaterialsQueue.clear();
+
     LOTUS_PROFILE_END_TIME(FrameTime::IndirectMaterialUpdateTime);
   }
 
-  void IndirectObjectRenderer::buildBatches()
+  void IndirectObjectRenderer::updateLODs(const Camera& camera)
   {
-    buildObjectBatches();
-    buildDrawBatches();
-    buildShaderBatches();
-  }
+    const glm::vec3 cameraPosition = camera.getLocalTranslation();
 
-  void IndirectObjectRenderer::buildObjectBatches()
-  {
-    LOTUS_PROFILE_START_TIME(FrameTime::IndirectObjectBatchBuildTime);
-
-    objectBatchesModified = !(toUnbatchObjects.empty() && unbatchedObjectsHandlers.empty());
-
-    if (!toUnbatchObjects.empty())
+    // Levels change over long distances, so small camera moves only revisit the objects that changed
+    if (glm::distance(cameraPosition, lodCameraPosition) > lodRefreshDistance)
     {
-      std::vector<ObjectBatch> deletionObjectBatches;
-      deletionObjectBatches.reserve(toUnbatchObjects.size());
-      
-      for (const IndirectRenderObject& object : toUnbatchObjects)
-      {
-        ObjectBatch batch;
+      lodCameraPosition = cameraPosition;
 
-        batch.object = Handler<IndirectRenderObject>(object.ID);
-        batch.mesh = object.mesh;
-        batch.shader = object.shader;
-
-        deletionObjectBatches.push_back(batch);
+      for (uint32_t i = 0; i < renderObjects.size(); i++)
+      {
+        if (objects[i] != nullptr)
+        {
+          updateLOD(renderObjects[i]);
+        }
       }
+    }
+    else
+    {
+      // Objects changing their level are queued again, only the ones queued before are visited
+      const size_t dirtyObjectsCount = dirtyObjectsHandlers.size();
 
-      toUnbatchObjects.clear();
-
-      std::sort(deletionObjectBatches.begin(), deletionObjectBatches.end());
-
-      std::vector<ObjectBatch> objectBatchesWithDeletion;
-      objectBatchesWithDeletion.reserve(objectBatches.size());
-
-      std::set_difference(objectBatches.begin(), objectBatches.end(), deletionObjectBatches.begin(), deletionObjectBatches.end(), std::back_inserter(objectBatchesWithDeletion));
+      for (size_t i = 0; i < dirtyObjectsCount; i++)
+      {
+        updateLOD(renderObjects[dirtyObjectsHandlers[i].handle]);
+      }
 
-      objectBatches = std::move(objectBatchesWithDeletion);
+      for (uint32_t i = 0; i < unbatchedObjectsHandlers.size(); i++)
+      {
+        updateLOD(renderObjects[unbatchedObjectsHandlers[i].handle]);
+      }
     }
+  }
+
+  void IndirectObjectRenderer::buildBatches()
+  {
+    buildObjectBatches();
+    buildDrawBatches();
+    buildShaderBatches();
+  }
 
+  void IndirectObjectRenderer::buildObjectBatches()
+  {
     if (!unbatchedObjectsHandlers.empty())
     {
-      std::vector<ObjectBatch> newObjectBatches;
+      LOTUS_PROFILE_START_TIME(FrameTime::IndirectObjectBatchBuildTime);
+
+      newObjectBatches.clear();
       newObjectBatches.reserve(unbatchedObjectsHandlers.size());
-      
+
       // Fill new render batches
       for (auto objectHandler : unbatchedObjectsHandlers)
       {
-        IndirectRenderObject& object = renderObjects[objectHandler.handle];
-        object.unbatched = false;
-
-        ObjectBatch batch;
-        batch.object.handle = object.ID;		
-        batch.mesh = object.mesh;
-        batch.shader = object.shader;
+        const IndirectRenderObject& object = renderObjects[objectHandler.handle];
 
-        newObjectBatches.push_back(batch);
+        newObjectBatches.emplace_back(Handler<IndirectRenderObject>(object.ID), object.lodMesh, object.shader);
       }
 
       unbatchedObjectsHandlers.clear();
 
-      // New render batches sort
-      std::sort(newObjectBatches.begin(), newObjectBatches.end());
-
-      // Merge the new render batches into the main render batch array
-      if (!objectBatches.empty() && !newObjectBatches.empty())
-      {
-        int index = objectBatches.size();
-        objectBatches.reserve(objectBatches.size() + newObjectBatches.size());
-        
-        for (const ObjectBatch& objectBatch : newObjectBatches)
-        {
-          objectBatches.push_back(objectBatch);
-        }
-
-        ObjectBatch* begin = objectBatches.data();
-        ObjectBatch* mid = begin + index;
-        ObjectBatch* end = begin + objectBatches.size();
-
-        std::inplace_merge(begin, mid, end);
-      }
-      else if (objectBatches.empty())
-      {
-        objectBatches = std::move(newObjectBatches);
-      }
+      // Sorting groups the new render batches by draw batch, so every draw batch is looked up once
+      radixSort(newObjectBatches, objectBatchesScratch, [](const ObjectBatch& batch) { return batch.key; });
 
+      LOTUS_PROFILE_END_TIME(FrameTime::IndirectObjectBatchBuildTime);
     }
-
-    LOTUS_PROFILE_END_TIME(FrameTime::IndirectObjectBatchBuildTime);
   }
 
   void IndirectObjectRenderer::buildDrawBatches()
   {
-    if (objectBatchesModified)
+    if (!newObjectBatches.empty())
     {
-      drawBatches.clear();
-      
-      if (!objectBatches.empty())
+      LOTUS_PROFILE_START_TIME(FrameTime::IndirectDrawBatchBuildTime);
+
+      size_t first = 0;
+
+      while (first < newObjectBatches.size())
       {
-        LOTUS_PROFILE_START_TIME(FrameTime::IndirectDrawBatchBuildTime);
-        
-        DrawBatch newDrawBatch;
-        newDrawBatch.prevInstanceCount = 0;
-        newDrawBatch.instanceCount = 0;
-        newDrawBatch.mesh = objectBatches[0].mesh;
-        newDrawBatch.shader = objectBatches[0].shader;
+        const Handler<IndirectRenderMesh> mesh = newObjectBatches[first].getMesh();
+        const Handler<ShaderProgram> shader = newObjectBatches[first].getShader();
 
-        drawBatches.push_back(newDrawBatch);
-        DrawBatch* backDrawBatch = &drawBatches.back();
+        size_t last = first + 1;
 
-        for (int i = 0; i < objectBatches.size(); i++)
+        while (last < newObjectBatches.size() && newObjectBatches[last].getMesh().handle == mesh.handle && newObjectBatches[last].getShader().handle == shader.handle)
         {
-          ObjectBatch* renderBatch = &objectBatches[i];
+          last++;
+        }
 
-          bool bSameMesh = renderBatch->mesh.handle == backDrawBatch->mesh.handle;
-          bool bSameShader = renderBatch->shader.handle == backDrawBatch->shader.handle;
+        auto drawBatch = findDrawBatch(shader, mesh);
 
-          if (bSameMesh && bSameShader)
-          {
-            backDrawBatch->instanceCount++;
-          }
-          else
-          {
-            DrawBatch newDrawBatch;
-            newDrawBatch.prevInstanceCount = i;
-            newDrawBatch.instanceCount = 1;
-            newDrawBatch.mesh = renderBatch->mesh;
-            newDrawBatch.shader = renderBatch->shader;
-
-            drawBatches.push_back(newDrawBatch);
-            backDrawBatch = &drawBatches.back();
-          }
+        if (drawBatch == drawBatches.end() || drawBatch->getKey() != DrawBatch::getKey(shader, mesh))
+        {
+          DrawBatch newDrawBatch;
+          newDrawBatch.mesh = mesh;
+          newDrawBatch.shader = shader;
+          newDrawBatch.firstInstance = 0;
+          newDrawBatch.capacity = 0;
+          newDrawBatch.instanceCount = 0;
+          newDrawBatch.visibleInstanceCount = 0;
+          newDrawBatch.dirty = true;
+
+          drawBatch = drawBatches.insert(drawBatch, newDrawBatch);
+          drawBatchesModified = true;
+        }
+
+        reserveDrawBatchInstances(*drawBatch, drawBatch->instanceCount + static_cast<uint32_t>(last - first));
+
+        for (size_t i = first; i < last; i++)
+        {
+          IndirectRenderObject& object = renderObjects[newObjectBatches[i].getObject().handle];
+
+          object.batchSlot = drawBatch->firstInstance + drawBatch->instanceCount;
+          object.unbatched = false;
+
+          batchedObjects[object.batchSlot] = object.ID;
+          drawBatch->instanceCount++;
         }
 
-        LOTUS_PROFILE_END_TIME(FrameTime::IndirectDrawBatchBuildTime);
+        drawBatch->dirty = true;
+
+        first = last;
       }
+
+      newObjectBatches.clear();
+
+      LOTUS_PROFILE_END_TIME(FrameTime::IndirectDrawBatchBuildTime);
     }
   }
 
   void IndirectObjectRenderer::buildShaderBatches()
   {
-    if (objectBatchesModified)
+    // Shader batches only change when a draw batch is added or removed
+    if (drawBatchesModified)
     {
       shaderBatches.clear();
 
@@ -392,37 +573,125 @@ namespace Lotus {
     }
   }
 
+  void IndirectObjectRenderer::cullObjects(const Camera& camera)
+  {
+    const glm::mat4 viewProjection = camera.getViewProjectionMatrix();
+
+    // Every draw batch is refreshed if the camera moved, otherwise only the ones whose instances changed
+    bool visibilityRefreshForced = visibilityRefreshRequired || (frustumCullingEnabled && viewProjection != previousViewProjection);
+
+    visibilityRefreshRequired = false;
+    previousViewProjection = viewProjection;
+
+    if (visibilityRefreshForced)
+    {
+      for (DrawBatch& drawBatch : drawBatches)
+      {
+        drawBatch.dirty = true;
+      }
+    }
+
+    // Without culling every instance is visible, the handles are written by refreshObjectHandleBuffer
+    if (!frustumCullingEnabled || drawBatches.empty())
+    {
+      return;
+    }
+
+    LOTUS_PROFILE_START_TIME(FrameTime::IndirectObjectCullingTime);
+
+    const Frustum frustum(viewProjection);
+
+    objectHandleBuffer.resize(objectHandleAllocator.getEnd());
+
+    uint32_t* objectHandleBufferMap = objectHandleBuffer.map();
+
+    for (uint32_t i = 0; i < drawBatches.size(); i++)
+    {
+      DrawBatch& drawBatch = drawBatches[i];
+
+      if (!drawBatch.dirty)
+      {
+        continue;
+      }
+
+      uint32_t visibleInstanceCount = 0;
+
+      for (uint32_t j = 0; j < drawBatch.instanceCount; j++)
+      {
+        const IndirectRenderObject& object = renderObjects[batchedObjects[drawBatch.firstInstance + j]];
+
+        if (frustum.intersectsSphere(object.boundingSphere))
+        {
+          // Visible instances are compacted at the beginning of the draw batch range
+          objectHandleBufferMap[drawBatch.firstInstance + visibleInstanceCount] = object.ID;
+          visibleInstanceCount++;
+        }
+      }
+
+      if (visibleInstanceCount > 0)
+      {
+        objectHandleBuffer.markDirty(drawBatch.firstInstance, visibleInstanceCount);
+      }
+
+      drawBatch.visibleInstanceCount = visibleInstanceCount;
+      drawBatch.dirty = false;
+
+      dirtyCommands.push_back(i);
+    }
+
+    objectHandleBuffer.unmap();
+
+    LOTUS_PROFILE_END_TIME(FrameTime::IndirectObjectCullingTime);
+  }
+
   void IndirectObjectRenderer::refreshBuffers()
   {
+    refreshObjectHandleBuffer();
     refreshIndirectBuffer();
     refreshObjectBuffer();
-    refreshObjectHandleBuffer();
     refreshMaterialBuffer();
   }
 
   void IndirectObjectRenderer::refreshIndirectBuffer()
   {
-    if (objectBatchesModified && !drawBatches.empty())
+    if (drawBatchesModified || !dirtyCommands.empty())
     {
       LOTUS_PROFILE_START_TIME(Lotus::FrameTime::IndirectIndirectBufferRefreshTime);
 
-      indirectBuffer.resize(drawBatches.size());
+      // Adding or removing a draw batch moves the commands after it, otherwise only the changed ones are written
+      if (drawBatchesModified)
+      {
+        dirtyCommands.resize(drawBatches.size());
+
+        for (uint32_t i = 0; i < drawBatches.size(); i++)
+        {
+          dirtyCommands[i] = i;
+        }
+
+        indirectBuffer.resize(drawBatches.size());
+
+        drawBatchesModified = false;
+      }
 
       DrawElementsIndirectCommand* indirectBufferMap = indirectBuffer.map();
 
-      for (int i = 0; i < drawBatches.size(); i++)
+      for (uint32_t i : dirtyCommands)
       {
         const DrawBatch& drawBatch = drawBatches[i];
         const IndirectRenderMesh& mesh = renderMeshes[drawBatch.mesh.handle];
 
         indirectBufferMap[i].count = mesh.count;
-        indirectBufferMap[i].instanceCount = drawBatch.instanceCount;
+        indirectBufferMap[i].instanceCount = drawBatch.visibleInstanceCount;
         indirectBufferMap[i].firstIndex = mesh.firstIndex;
         indirectBufferMap[i].baseVertex = mesh.baseVertex;
-        indirectBufferMap[i].baseInstance = drawBatch.prevInstanceCount;
+        indirectBufferMap[i].baseInstance = drawBatch.firstInstance;
+
+        indirectBuffer.markDirty(i);
       }
 
       indirectBuffer.unmap();
+
+      dirtyCommands.clear();
       
       LOTUS_PROFILE_END_TIME(Lotus::FrameTime::IndirectIndirectBufferRefreshTime);
     }
@@ -440,8 +709,10 @@ namespace Lotus {
       {
         const IndirectRenderObject& object = renderObjects[objectHandler.handle];
 
-        objectBufferMap[object.ID].model = object.model;
-        objectBufferMap[object.ID].materialHandle = object.material.handle;
+        objectBufferMap[object.ID].model = renderMeshes[object.lodMesh.handle].quantization.getModelMatrix(object.model);
+        objectBufferMap[object.ID].materialHandle = renderMaterials[object.material.handle].ID;
+
+        objectBuffer.markDirty(object.ID);
       }
 
       objectBuffer.unmap();
@@ -454,27 +725,43 @@ namespace Lotus {
 
   void IndirectObjectRenderer::refreshObjectHandleBuffer()
   {
-    if (objectBatchesModified && !drawBatches.empty())
+    // When frustum culling is enabled, the handles are written by the culling stage
+    if (!frustumCullingEnabled && !drawBatches.empty())
     {
       LOTUS_PROFILE_START_TIME(Lotus::FrameTime::IndirectObjectHandleBufferRefreshTime);
 
-      objectHandleBuffer.resize(objectBatches.size());
+      objectHandleBuffer.resize(objectHandleAllocator.getEnd());
 
-      uint32_t* objectHandleBufferMap = objectHandleBuffer.map();
+      uint32_t* objectHandleBufferMap = nullptr;
 
-      int index = 0;
-      for (int dI = 0; dI < drawBatches.size(); dI++)
+      for (uint32_t i = 0; i < drawBatches.size(); i++)
       {
-        auto drawBatch = drawBatches[dI];
+        DrawBatch& drawBatch = drawBatches[i];
 
-        for (int iI = 0; iI < drawBatch.instanceCount; iI++)
+        if (!drawBatch.dirty)
         {
-          objectHandleBufferMap[index] = renderObjects[objectBatches[drawBatch.prevInstanceCount + iI].object.handle].ID;
-          index++;
+          continue;
         }
+
+        if (objectHandleBufferMap == nullptr)
+        {
+          objectHandleBufferMap = objectHandleBuffer.map();
+        }
+
+        std::copy_n(batchedObjects.begin() + drawBatch.firstInstance, drawBatch.instanceCount, objectHandleBufferMap + drawBatch.firstInstance);
+
+        objectHandleBuffer.markDirty(drawBatch.firstInstance, drawBatch.instanceCount);
+
+        drawBatch.visibleInstanceCount = drawBatch.instanceCount;
+        drawBatch.dirty = false;
+
+        dirtyCommands.push_back(i);
       }
 
-      objectHandleBuffer.unmap();
+      if (objectHandleBufferMap != nullptr)
+      {
+        objectHandleBuffer.unmap();
+      }
 
       LOTUS_PROFILE_END_TIME(Lotus::FrameTime::IndirectObjectHandleBufferRefreshTime);
     }
@@ -495,6 +782,8 @@ namespace Lotus {
         const std::shared_ptr<Material>& material = materials[materialHandler.handle];
 
         materialBufferMap[renderMaterial.ID] = materials[materialHandler.handle]->getMaterialData();
+
+        materialBuffer.markDirty(renderMaterial.ID);
       }
 
       materialBuffer.unmap();
@@ -505,66 +794,388 @@ namespace Lotus {
     }
   }
 
-  Handler<IndirectRenderMesh> IndirectObjectRenderer::getMeshHandler(const std::shared_ptr<Mesh>& mesh)
+  void IndirectObjectRenderer::loadShaders()
+  {
+    vertexAttributes = 0;
+
+    auto loadShader = [this](MaterialType type, const std::string& name)
+    {
+      const uint32_t attributes = getVertexAttributes(type);
+
+      shaders[static_cast<unsigned int>(type)] = ShaderProgram(
+          shaderPath("indirect/" + name + ".vert"),
+          shaderPath("indirect/" + name + ".frag"),
+          getVertexShaderDefines(vertexFormat, attributes));
+
+      vertexAttributes |= attributes;
+    };
+
+    loadShader(MaterialType::UnlitFlat, "unlit_flat");
+    loadShader(MaterialType::DiffuseFlat, "diffuse_flat");
+
+    if (supportsTexturedMaterials)
+    {
+      loadShader(MaterialType::DiffuseTextured, "diffuse_textured");
+    }
+  }
+
+  uint32_t IndirectObjectRenderer::addVertices(const std::vector<MeshVertex>& vertices, const VertexQuantization& quantization)
   {
-    Handler<IndirectRenderMesh> handler;
+    if (vertexFormat == VertexFormat::Full)
+    {
+      if (!vertexBuffer.allocated)
+      {
+        vertexBuffer.allocate(VertexBufferInitialAllocationSize);
+        vertexBuffer.setVertexArray(vertexArrayID, vertexAttributes);
+      }
 
-    auto it = meshMap.find(mesh);
+      return vertexBuffer.add(vertices.data(), vertices.size());
+    }
 
-    if (it == meshMap.end())
+    if (!compactVertexBuffer.allocated)
+    {
+      compactVertexBuffer.allocate(VertexBufferInitialAllocationSize);
+      compactVertexBuffer.setVertexArray(vertexArrayID, vertexAttributes);
+    }
+
+    std::vector<CompactVertex> compactVertices(vertices.size());
+
+    std::transform(vertices.begin(), vertices.end(), compactVertices.begin(), [&quantization](const MeshVertex& vertex)
+    {
+      return quantization.compress(vertex);
+    });
+
+    return compactVertexBuffer.add(compactVertices.data(), compactVertices.size());
+  }
+
+  void IndirectObjectRenderer::removeVertices(uint32_t first, uint32_t count)
+  {
+    if (vertexFormat == VertexFormat::Full)
+    {
+      vertexBuffer.remove(first, count);
+    }
+    else
+    {
+      compactVertexBuffer.remove(first, count);
+    }
+  }
+
+  Handler<IndirectRenderMesh> IndirectObjectRenderer::acquireMeshHandler(const std::shared_ptr<Mesh>& mesh)
+  {
+    const uint32_t resourceID = mesh->getResourceID();
+
+    if (resourceID >= meshMap.size())
+    {
+      meshMap.resize(resourceID + 1, { Handler<IndirectRenderMesh>::InvalidHandle });
+    }
+
+    Handler<IndirectRenderMesh> handler = meshMap[resourceID];
+
+    if (handler.handle == Handler<IndirectRenderMesh>::InvalidHandle)
     {
       const std::vector<MeshVertex>& vertices = mesh->getVertices();
       const std::vector<unsigned int>& indices = mesh->getIndices();
 
-      uint32_t verticesBufferLocation = vertexBuffer.add(vertices.data(), vertices.size()); 
+      IndirectRenderMesh renderMesh;
+
+      if (vertexFormat == VertexFormat::Compact)
+      {
+        renderMesh.quantization = VertexQuantization::fromBounds(mesh->getAABB());
+      }
+
+      uint32_t verticesBufferLocation = addVertices(vertices, renderMesh.quantization);
       uint32_t indicesBufferLocation = indexBuffer.add(indices.data(), indices.size());
 
-      IndirectRenderMesh renderMesh;
       renderMesh.firstIndex = indicesBufferLocation;
       renderMesh.baseVertex = verticesBufferLocation;
       renderMesh.count = indices.size();
+      renderMesh.vertexCount = vertices.size();
+      renderMesh.aabb = mesh->getAABB();
+      renderMesh.boundingSphere = mesh->getBoundingSphere();
 
-      handler.handle = static_cast<uint32_t>(renderMeshes.size());
-      renderMeshes.push_back(renderMesh);
+      // Every level is kept loaded while this mesh is
+      float previousDistance = 0.0f;
 
-      meshMap[mesh] = handler;
-    }
-    else
-    {
-      handler = (*it).second;
+      for (const Mesh::LOD& lod : mesh->getLODs())
+      {
+        renderMesh.lods.push_back({ acquireMeshHandler(lod.mesh), lod.distance * lod.distance });
+
+        if (lod.distance > previousDistance)
+        {
+          renderMesh.lodSpacing = std::min(renderMesh.lodSpacing, lod.distance - previousDistance);
+          previousDistance = lod.distance;
+        }
+      }
+
+      lodRefreshDistance = std::min(lodRefreshDistance, LODRefreshFraction * renderMesh.lodSpacing);
+
+      // Handlers of evicted meshes are reused, so the handlers range stays compact
+      if (!freeMeshesHandlers.empty())
+      {
+        handler = freeMeshesHandlers.back();
+        freeMeshesHandlers.pop_back();
+
+        meshes[handler.handle] = mesh;
+        renderMeshes[handler.handle] = renderMesh;
+      }
+      else
+      {
+        handler.handle = static_cast<uint32_t>(renderMeshes.size());
+
+        meshes.push_back(mesh);
+        renderMeshes.push_back(renderMesh);
+      }
+
+      meshMap[resourceID] = handler;
     }
 
+    renderMeshes[handler.handle].references++;
+
     return handler;
   }
 
-  Handler<IndirectRenderMaterial> IndirectObjectRenderer::getMaterialHandler(const std::shared_ptr<Material>& material)
+  Handler<IndirectRenderMaterial> IndirectObjectRenderer::acquireMaterialHandler(const std::shared_ptr<Material>& material)
   {
-    Handler<IndirectRenderMaterial> handler;
+    const uint32_t resourceID = material->getResourceID();
 
-    auto it = materialMap.find(material);
-
-    if (it == materialMap.end())
+    if (resourceID >= materialMap.size())
     {
-      materials.push_back(material);
+      materialMap.resize(resourceID + 1, { Handler<IndirectRenderMaterial>::InvalidHandle });
+    }
 
+    Handler<IndirectRenderMaterial> handler = materialMap[resourceID];
+
+    if (handler.handle == Handler<IndirectRenderMaterial>::InvalidHandle)
+    {
       GPUMaterialData GPUMaterial = material->getMaterialData();
       
       uint32_t materialID = materialBuffer.add(&GPUMaterial);
 
       IndirectRenderMaterial renderMaterial;
       renderMaterial.ID = materialID;
+
+      if (!freeMaterialsHandlers.empty())
+      {
+        handler = freeMaterialsHandlers.back();
+        freeMaterialsHandlers.pop_back();
+
+        materials[handler.handle] = material;
+        renderMaterials[handler.handle] = renderMaterial;
+      }
+      else
+      {
+        handler.handle = static_cast<uint32_t>(renderMaterials.size());
+
+        materials.push_back(material);
+        renderMaterials.push_back(renderMaterial);
+      }
       
-      handler.handle = static_cast<uint32_t>(renderMaterials.size());
-      renderMaterials.push_back(renderMaterial);
-      
-      materialMap[material] = handler;
+      materialMap[resourceID] = handler;
+
+      // The data was just uploaded, later changes are queued by the material
+      material->dirty = false;
+      material->dirtyQueue = &dirtyMaterialsQueue;
     }
-    else
+
+    renderMaterials[handler.handle].references++;
+
+    return handler;
+  }
+
+  void IndirectObjectRenderer::releaseMeshHandler(Handler<IndirectRenderMesh> handler)
+  {
+    IndirectRenderMesh& renderMesh = renderMeshes[handler.handle];
+
+    if (--renderMesh.references > 0)
     {
-      handler = (*it).second;
+      return;
     }
 
-    return handler;
+    if (renderMesh.vertexCount > 0)
+    {
+      removeVertices(renderMesh.baseVertex, renderMesh.vertexCount);
+    }
+
+    if (renderMesh.count > 0)
+    {
+      indexBuffer.remove(renderMesh.firstIndex, renderMesh.count);
+    }
+
+    // Dropping the pointer lets MeshManager::cleanUnusedMeshes free the mesh
+    meshMap[meshes[handler.handle]->getResourceID()].handle = Handler<IndirectRenderMesh>::InvalidHandle;
+    meshes[handler.handle] = nullptr;
+
+    freeMeshesHandlers.push_back(handler);
+
+    std::vector<IndirectRenderMeshLOD> lods = std::move(renderMesh.lods);
+    renderMesh.lods.clear();
+
+    for (const IndirectRenderMeshLOD& lod : lods)
+    {
+      releaseMeshHandler(lod.mesh);
+    }
+
+    // The refresh distance may have been set by this mesh
+    if (!lods.empty())
+    {
+      refreshLODRefreshDistance();
+    }
+  }
+
+  void IndirectObjectRenderer::releaseMaterialHandler(Handler<IndirectRenderMaterial> handler)
+  {
+    IndirectRenderMaterial& renderMaterial = renderMaterials[handler.handle];
+
+    if (--renderMaterial.references > 0)
+    {
+      return;
+    }
+
+    materialBuffer.remove(renderMaterial.ID);
+
+    materials[handler.handle]->dirtyQueue = nullptr;
+
+    materialMap[materials[handler.handle]->getResourceID()].handle = Handler<IndirectRenderMaterial>::InvalidHandle;
+    materials[handler.handle] = nullptr;
+
+    freeMaterialsHandlers.push_back(handler);
+  }
+
+  std::vector<DrawBatch>::iterator IndirectObjectRenderer::findDrawBatch(Handler<ShaderProgram> shader, Handler<IndirectRenderMesh> mesh)
+  {
+    const uint64_t key = DrawBatch::getKey(shader, mesh);
+
+    return std::lower_bound(drawBatches.begin(), drawBatches.end(), key, [](const DrawBatch& drawBatch, uint64_t key) { return drawBatch.getKey() < key; });
+  }
+
+  void IndirectObjectRenderer::unbatchObject(IndirectRenderObject& renderObject)
+  {
+    auto drawBatch = findDrawBatch(renderObject.shader, renderObject.lodMesh);
+
+    // The last instance of the draw batch takes the place of the removed one
+    const uint32_t lastSlot = drawBatch->firstInstance + drawBatch->instanceCount - 1;
+    const uint32_t movedObject = batchedObjects[lastSlot];
+
+    batchedObjects[renderObject.batchSlot] = movedObject;
+    renderObjects[movedObject].batchSlot = renderObject.batchSlot;
+
+    drawBatch->instanceCount--;
+    drawBatch->dirty = true;
+
+    if (drawBatch->instanceCount == 0)
+    {
+      objectHandleAllocator.free(drawBatch->firstInstance, drawBatch->capacity);
+
+      drawBatches.erase(drawBatch);
+      drawBatchesModified = true;
+    }
+  }
+
+  void IndirectObjectRenderer::reserveDrawBatchInstances(DrawBatch& drawBatch, uint32_t instanceCount)
+  {
+    if (instanceCount <= drawBatch.capacity)
+    {
+      return;
+    }
+
+    // Capacity doubles, so a draw batch receiving objects one by one only moves a logarithmic amount of times
+    const uint32_t capacity = std::max({ instanceCount, 2 * drawBatch.capacity, static_cast<uint32_t>(DrawBatchMinimumCapacity) });
+    const uint32_t firstInstance = objectHandleAllocator.allocate(capacity);
+
+    if (batchedObjects.size() < objectHandleAllocator.getEnd())
+    {
+      batchedObjects.resize(objectHandleAllocator.getEnd());
+    }
+
+    for (uint32_t i = 0; i < drawBatch.instanceCount; i++)
+    {
+      const uint32_t objectHandle = batchedObjects[drawBatch.firstInstance + i];
+
+      batchedObjects[firstInstance + i] = objectHandle;
+      renderObjects[objectHandle].batchSlot = firstInstance + i;
+    }
+
+    if (drawBatch.capacity > 0)
+    {
+      objectHandleAllocator.free(drawBatch.firstInstance, drawBatch.capacity);
+    }
+
+    drawBatch.firstInstance = firstInstance;
+    drawBatch.capacity = capacity;
+    drawBatch.dirty = true;
+  }
+
+  void IndirectObjectRenderer::updateBoundingSphere(IndirectRenderObject& renderObject)
+  {
+    renderObject.boundingSphere = renderMeshes[renderObject.mesh.handle].boundingSphere.transform(renderObject.model);
+  }
+
+  void IndirectObjectRenderer::updateLOD(IndirectRenderObject& renderObject)
+  {
+    const std::vector<IndirectRenderMeshLOD>& lods = renderMeshes[renderObject.mesh.handle].lods;
+
+    // Levels past the current one are left below a shorter distance, so objects on a threshold don't switch every frame
+    uint32_t currentLevel = 0;
+
+    for (uint32_t i = 0; i < lods.size(); i++)
+    {
+      if (lods[i].mesh.handle == renderObject.lodMesh.handle)
+      {
+        currentLevel = i + 1;
+      }
+    }
+
+    Handler<IndirectRenderMesh> lodMesh = renderObject.mesh;
+
+    const glm::vec3 offset = renderObject.boundingSphere.center - lodCameraPosition;
+    const float distanceSquared = glm::dot(offset, offset);
+
+    for (uint32_t i = 0; i < lods.size(); i++)
+    {
+      const float lodDistanceSquared = i < currentLevel ? lods[i].distanceSquared * LODHysteresis * LODHysteresis : lods[i].distanceSquared;
+
+      if (distanceSquared < lodDistanceSquared)
+      {
+        break;
+      }
+
+      lodMesh = lods[i].mesh;
+    }
+
+    if (lodMesh.handle == renderObject.lodMesh.handle)
+    {
+      return;
+    }
+
+    // The object moves to the draw batch of its new level
+    if (!renderObject.unbatched)
+    {
+      unbatchObject(renderObject);
+      unbatchedObjectsHandlers.push_back(Handler<IndirectRenderObject>(renderObject.ID));
+
+      renderObject.unbatched = true;
+    }
+
+    // Every level is quantized inside its own bounds, so the model matrix of the object data changes with it
+    if (vertexFormat == VertexFormat::Compact)
+    {
+      dirtyObjectsHandlers.push_back(Handler<IndirectRenderObject>(renderObject.ID));
+    }
+
+    renderObject.lodMesh = lodMesh;
+  }
+
+  void IndirectObjectRenderer::refreshLODRefreshDistance()
+  {
+    lodRefreshDistance = std::numeric_limits<float>::max();
+
+    for (uint32_t i = 0; i < renderMeshes.size(); i++)
+    {
+      if (meshes[i] != nullptr && !renderMeshes[i].lods.empty())
+      {
+        lodRefreshDistance = std::min(lodRefreshDistance, LODRefreshFraction * renderMeshes[i].lodSpacing);
+      }
+    }
   }
 
 }
\ No newline at end of file
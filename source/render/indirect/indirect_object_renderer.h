@@ -3,16 +3,17 @@
 #include <memory>
 #include <array>
 #include <vector>
-#include <unordered_map>
 #include "../../math/types.h"
 #include "../../scene/transform.h"
 #include "../../scene/camera.h"
+#include "../../util/thread_pool.h"
 #include "../gpu_structures.h"
 #include "../gpu_buffer.h"
 #include "../mesh.h"
 #include "../shader.h"
 #include "../material.h"
 #include "../mesh_object.h"
+#include "../object_store.h"
 #include "indirect_render_structures.h"
 
 
@@ -27,23 +28,43 @@ namespace Lotus
     static constexpr unsigned int IndirectBufferInitialAllocationSize = 1 << 10;
     static constexpr unsigned int ObjectBufferInitialAllocationSize = 1 << 10;
     static constexpr unsigned int MaterialBufferInitialAllocationSize = 1 << 8;
+    static constexpr float MeshBufferFragmentationLimit = 0.5f;
+    static constexpr unsigned int ModelMatrixBatchSize = 1 << 10;
+    static constexpr unsigned int DrawBatchMinimumCapacity = 16;
+    static constexpr float LODRefreshFraction = 0.25f;  // Of the smallest spacing between levels the camera moves before they are all revisited
+    static constexpr float LODHysteresis = 0.9f;        // Of the distance of a level an object has to come back under to leave it
 
-    IndirectObjectRenderer();
+    IndirectObjectRenderer(ThreadPool& engineThreadPool);
     ~IndirectObjectRenderer();
 
-    std::shared_ptr<MeshObject> createObject(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material);
+    std::shared_ptr<MeshObject> createObject(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material);
+    void destroyObject(const std::shared_ptr<MeshObject>& object);
 
-    void render();
+    uint32_t getObjectsCount() const { return objectsCount; }
+
+    void render(const Camera& camera);
+
+    void setFrustumCullingEnabled(bool enabled);
+    bool isFrustumCullingEnabled() const { return frustumCullingEnabled; }
+
+    // The format can only change while the renderer has no meshes
+    void setVertexFormat(VertexFormat format);
+    VertexFormat getVertexFormat() const { return vertexFormat; }
 
     void update();
     void updateObjects();
     void updateMaterials();
+    void updateLODs(const Camera& camera);
+
+    void compactMeshBuffers();
 
     void buildBatches();
     void buildObjectBatches();
     void buildDrawBatches();
     void buildShaderBatches();
 
+    void cullObjects(const Camera& camera);
+
     void refreshBuffers();
     void refreshIndirectBuffer();
     void refreshObjectBuffer();
@@ -52,48 +73,96 @@ namespace Lotus
 
   private:
 
-    Handler<IndirectRenderMesh> getMeshHandler(const std::shared_ptr<Mesh>& mesh);
-    Handler<IndirectRenderMaterial> getMaterialHandler(const std::shared_ptr<Material>& material);
+    // Programs of every supported material type, reading the vertex attributes they declare in the current format
+    void loadShaders();
+
+    // Vertices are stored in the buffer of the current format, compact ones quantized inside the mesh bounds
+    uint32_t addVertices(const std::vector<MeshVertex>& vertices, const VertexQuantization& quantization);
+    void removeVertices(uint32_t first, uint32_t count);
+
+    // Each acquired handler holds a reference, the mesh or material is evicted once all of them are released
+    Handler<IndirectRenderMesh> acquireMeshHandler(const std::shared_ptr<Mesh>& mesh);
+    Handler<IndirectRenderMaterial> acquireMaterialHandler(const std::shared_ptr<Material>& material);
+    void releaseMeshHandler(Handler<IndirectRenderMesh> handler);
+    void releaseMaterialHandler(Handler<IndirectRenderMaterial> handler);
+
+    void updateBoundingSphere(IndirectRenderObject& renderObject);
+    void updateLOD(IndirectRenderObject& renderObject);
+    void refreshLODRefreshDistance();
+
+    // Draw batches are looked up by their key, returns drawBatches.end() if there is none
+    std::vector<DrawBatch>::iterator findDrawBatch(Handler<ShaderProgram> shader, Handler<IndirectRenderMesh> mesh);
+    void unbatchObject(IndirectRenderObject& renderObject);
+    void reserveDrawBatchInstances(DrawBatch& drawBatch, uint32_t instanceCount);
 
     /* Shaders */
     std::array<ShaderProgram, static_cast<unsigned int>(MaterialType::MaterialTypeCount)> shaders;
 
-    /* Maps */
-	  std::unordered_map<std::shared_ptr<Mesh>, Handler<IndirectRenderMesh>> meshMap;
-	  std::unordered_map<std::shared_ptr<Material>, Handler<IndirectRenderMaterial>> materialMap;
+    /* Maps (indexed by resource ID) */
+    std::vector<Handler<IndirectRenderMesh>> meshMap;
+    std::vector<Handler<IndirectRenderMaterial>> materialMap;
 
     /* Objects */
+    uint32_t objectsCount;
+    ObjectStore objectStore;
     std::vector<std::shared_ptr<MeshObject>> objects;
     std::vector<IndirectRenderObject> renderObjects;
     std::vector<Handler<IndirectRenderObject>> dirtyObjectsHandlers;
-    std::vector<IndirectRenderObject> toUnbatchObjects;
+    std::vector<uint32_t> movedObjectsHandlers;
     std::vector<Handler<IndirectRenderObject>> unbatchedObjectsHandlers;
     
     /* Materials */
     std::vector<std::shared_ptr<Material>> materials;
     std::vector<IndirectRenderMaterial> renderMaterials;
     std::vector<Handler<IndirectRenderMaterial>> dirtyMaterialsHandlers;
+    std::vector<uint32_t> dirtyMaterialsQueue;
+    std::vector<Handler<IndirectRenderMaterial>> freeMaterialsHandlers;
 
     /* Meshes */
+    std::vector<std::shared_ptr<Mesh>> meshes;
     std::vector<IndirectRenderMesh> renderMeshes;
+    std::vector<Handler<IndirectRenderMesh>> freeMeshesHandlers;
 
     /* Batches */
-    bool objectBatchesModified;
-    std::vector<ObjectBatch> objectBatches;
+    bool drawBatchesModified;
+    std::vector<ObjectBatch> newObjectBatches;
+    std::vector<ObjectBatch> objectBatchesScratch;
     std::vector<DrawBatch> drawBatches;
     std::vector<ShaderBatch> shaderBatches;
 
+    // Object handle buffer ranges of the draw batches, and the objects placed in them
+    BlockAllocator objectHandleAllocator;
+    std::vector<uint32_t> batchedObjects;
+    std::vector<uint32_t> dirtyCommands;
+
+    /* Levels of detail */
+    glm::vec3 lodCameraPosition;
+    float lodRefreshDistance;
+
+    /* Culling */
+    bool frustumCullingEnabled;
+    bool visibilityRefreshRequired;
+    glm::mat4 previousViewProjection;
+
     /* Buffers */
     uint32_t vertexArrayID;
 
-    VertexBuffer vertexBuffer;
+    // Only the buffer of the current vertex format is allocated, once the first mesh is added
+    VertexFormat vertexFormat;
+    uint32_t vertexAttributes;
+    VertexBuffer<MeshVertex> vertexBuffer;
+    VertexBuffer<CompactVertex> compactVertexBuffer;
     IndexBuffer indexBuffer;
 
-    DrawIndirectBuffer indirectBuffer;
+    // Per frame data is written straight to persistently mapped memory without upload calls, see GPUBufferMapping::Persistent
+    DrawIndirectBuffer<GPUBufferMapping::Persistent> indirectBuffer;
+
+    ShaderStorageBuffer<GPUObjectData, GPUBufferMapping::Persistent> objectBuffer;
+    ShaderStorageBuffer<uint32_t, GPUBufferMapping::Persistent> objectHandleBuffer;
+    ShaderStorageBuffer<GPUMaterialData, GPUBufferMapping::Persistent> materialBuffer;
 
-    ShaderStorageBuffer<GPUObjectData> objectBuffer;
-    ShaderStorageBuffer<uint32_t> objectHandleBuffer;
-    ShaderStorageBuffer<GPUMaterialData> materialBuffer;
+    /* Workers, shared with the rest of the engine */
+    ThreadPool& threadPool;
 
     /* Extensions support */
     bool supportsTexturedMaterials;
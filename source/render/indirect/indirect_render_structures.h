@@ -1,12 +1,27 @@
 #pragma once
 
+#include <vector>
+#include <limits>
 #include "../../math/types.h"
+#include "../../math/bounds.h"
+#include "../vertex_layout.h"
 
 namespace Lotus
 {
 
   class ShaderProgram;
 
+  struct IndirectRenderMesh;
+
+  /*
+    Level of detail of a mesh, used from the given squared camera distance on
+  */
+  struct IndirectRenderMeshLOD
+  {
+    Handler<IndirectRenderMesh> mesh;
+    float distanceSquared;
+  };
+
   /*
     Structure with a mesh GPU identifiers
   */
@@ -15,7 +30,13 @@ namespace Lotus
     uint32_t count;
     uint32_t firstIndex;
     uint32_t baseVertex;
-    uint32_t references;
+    uint32_t vertexCount;
+    uint32_t references = 0;
+    AABB aabb;
+    BoundingSphere boundingSphere;
+    VertexQuantization quantization;  // Identity unless the vertices are compact
+    std::vector<IndirectRenderMeshLOD> lods;
+    float lodSpacing = std::numeric_limits<float>::max();  // Smallest distance between two consecutive levels
   };
 
   /*
@@ -24,7 +45,7 @@ namespace Lotus
   struct IndirectRenderMaterial
   {
     uint32_t ID = 0;
-    uint32_t references;
+    uint32_t references = 0;
   };
 
   /*
@@ -34,9 +55,12 @@ namespace Lotus
   {
     uint32_t ID = 0;
     Handler<IndirectRenderMesh> mesh;
+    Handler<IndirectRenderMesh> lodMesh;  // Level of detail of the mesh the object is batched with
     Handler<IndirectRenderMaterial> material;
     Handler<ShaderProgram> shader;
     glm::mat4 model;
+    BoundingSphere boundingSphere;
+    uint32_t batchSlot = 0;  // Place in the object handle buffer while it is batched
     bool unbatched = true;
   };
 
@@ -51,39 +75,53 @@ namespace Lotus
   };
 
   /*
-    Batch for objects with the same mesh and shader
+    Batch for objects with the same mesh and shader. Its instances own a range of the object handle
+    buffer with room to grow, so adding or removing one of them only rewrites that range and its command
   */
   struct DrawBatch
   {
     Handler<IndirectRenderMesh> mesh;
     Handler<ShaderProgram> shader;
-    uint32_t prevInstanceCount;
+    uint32_t firstInstance;
+    uint32_t capacity;
     uint32_t instanceCount;
+    uint32_t visibleInstanceCount;
+    bool dirty;
+
+    // Draw batches are kept ordered by this key, so the commands of every shader are contiguous
+    static uint64_t getKey(Handler<ShaderProgram> shader, Handler<IndirectRenderMesh> mesh)
+    {
+      return (static_cast<uint64_t>(shader.handle) << 32) | mesh.handle;
+    }
+
+    uint64_t getKey() const { return getKey(shader, mesh); }
   };
 
   /*
-    Batch for a single object
+    Batch for a single object, packed in a key ordered by shader, mesh and object so sorting the
+    batches groups the instances of every draw batch
   */
   struct ObjectBatch
   {
-    Handler<IndirectRenderObject> object;
-    Handler<IndirectRenderMesh> mesh;
-    Handler<ShaderProgram> shader;
+    static constexpr int ObjectBits = 32;
+    static constexpr int MeshBits = 24;
+    static constexpr int ShaderBits = 8;
+
+    ObjectBatch() : key(0) {}
+
+    ObjectBatch(Handler<IndirectRenderObject> object, Handler<IndirectRenderMesh> mesh, Handler<ShaderProgram> shader) :
+      key((static_cast<uint64_t>(shader.handle) << (MeshBits + ObjectBits)) | (static_cast<uint64_t>(mesh.handle) << ObjectBits) | object.handle) {}
+
+    Handler<IndirectRenderObject> getObject() const { return Handler<IndirectRenderObject>(static_cast<uint32_t>(key)); }
+    Handler<IndirectRenderMesh> getMesh() const { return Handler<IndirectRenderMesh>(static_cast<uint32_t>((key >> ObjectBits) & ((1ull << MeshBits) - 1))); }
+    Handler<ShaderProgram> getShader() const { return Handler<ShaderProgram>(static_cast<uint32_t>(key >> (MeshBits + ObjectBits))); }
 
     bool operator<(const ObjectBatch& other) const
     {
-      if (shader.handle != other.shader.handle)
-      {
-        return shader.handle < other.shader.handle;
-      }
-
-      if (mesh.handle != other.mesh.handle)
-      {
-        return mesh.handle < other.mesh.handle;
-      }
-      
-      return object.handle < other.object.handle;
+      return key < other.key;
     }
+
+    uint64_t key;
   };
 
 }
\ No newline at end of file
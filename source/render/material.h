@@ -1,8 +1,11 @@
 #pragma once
 
+#include <vector>
 #include "../math/types.h"
 #include "gpu_structures.h"
 #include "shader.h"
+#include "resource_id.h"
+#include "vertex_layout.h"
 
 namespace Lotus
 {
@@ -17,17 +20,42 @@ namespace Lotus
     MaterialTypeCount
   };
 
+  // Vertex attributes read by the shaders of each material type, see VertexAttribute
+  constexpr uint32_t getVertexAttributes(MaterialType type)
+  {
+    switch (type)
+    {
+    case MaterialType::UnlitFlat:
+      return PositionAttribute;
+    case MaterialType::UnlitTextured:
+      return PositionAttribute | UVAttribute;
+    case MaterialType::DiffuseFlat:
+    case MaterialType::PBRFlat:
+      return PositionAttribute | NormalAttribute;
+    case MaterialType::DiffuseTextured:
+      return PositionAttribute | NormalAttribute | UVAttribute;
+    case MaterialType::PBRTextured:
+      return AllVertexAttributes;
+    default:
+      return AllVertexAttributes;
+    }
+  }
+
   class Material
   {
   friend class IndirectObjectRenderer;
 
   public:
-    Material() : dirty(false) {}
+    Material() : dirty(false), dirtyQueue(nullptr) {}
     
     virtual ~Material() = default;
 
     MaterialType getType() { return type; };
 
+    uint32_t getVertexAttributes() const { return Lotus::getVertexAttributes(type); }
+
+    uint32_t getResourceID() const { return resourceID.get(); }
+
     void setUniforms(const glm::mat4& modelMatrix);
 
     virtual void setMaterialUniforms() = 0;
@@ -35,8 +63,27 @@ namespace Lotus
     virtual GPUMaterialData getMaterialData() = 0;
 
   protected:
+    // Flags the material as changed, queueing it once for the renderer tracking it
+    void markDirty()
+    {
+      if (dirty)
+      {
+        return;
+      }
+
+      dirty = true;
+
+      if (dirtyQueue != nullptr)
+      {
+        dirtyQueue->push_back(getResourceID());
+      }
+    }
+
     MaterialType type;
     bool dirty;
+    std::vector<uint32_t>* dirtyQueue;
+
+    ResourceID<Material> resourceID;
   };
 }
 
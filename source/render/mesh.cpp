@@ -3,6 +3,7 @@
 #include <iostream>
 #include <vector>
 #include <stack>
+#include <algorithm>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -118,6 +119,8 @@ namespace Lotus
         sceneTransforms.push(currentNode->mChildren[j]->mTransformation * currentTransform);
       }
     }
+
+    computeBounds();
   }
 
   Mesh::Mesh(PrimitiveType type)
@@ -129,6 +132,8 @@ namespace Lotus
         Plane plane;
         vertices = plane.vertices;
         indices = plane.indices;
+        aabb = plane.aabb;
+        boundingSphere = plane.boundingSphere;
         break;
       }
       case Mesh::PrimitiveType::Cube:
@@ -136,6 +141,8 @@ namespace Lotus
         Cube cube;
         vertices = cube.vertices;
         indices = cube.indices;
+        aabb = cube.aabb;
+        boundingSphere = cube.boundingSphere;
         break;
       }
       case Mesh::PrimitiveType::Sphere:
@@ -143,6 +150,8 @@ namespace Lotus
         Sphere sphere;
         vertices = sphere.vertices;
         indices = sphere.indices;
+        aabb = sphere.aabb;
+        boundingSphere = sphere.boundingSphere;
         break;
       }
       default:
@@ -150,15 +159,58 @@ namespace Lotus
         Sphere sphere;
         vertices = sphere.vertices;
         indices = sphere.indices;
+        aabb = sphere.aabb;
+        boundingSphere = sphere.boundingSphere;
         break;
       }
     }
   }
 
+  Mesh::Mesh(std::vector<MeshVertex> meshVertices, std::vector<unsigned int> meshIndices) :
+    vertices(std::move(meshVertices)),
+    indices(std::move(meshIndices))
+  {
+    computeBounds();
+  }
+
   Mesh::~Mesh()
   {
   }
 
+  void Mesh::setLODs(std::vector<LOD> meshLODs)
+  {
+    meshLODs.erase(std::remove_if(meshLODs.begin(), meshLODs.end(), [](const LOD& lod) { return lod.mesh == nullptr; }), meshLODs.end());
+
+    std::sort(meshLODs.begin(), meshLODs.end(), [](const LOD& a, const LOD& b) { return a.distance < b.distance; });
+
+    lods = std::move(meshLODs);
+  }
+
+  void Mesh::computeBounds()
+  {
+    aabb = AABB();
+
+    for (const MeshVertex& vertex : vertices)
+    {
+      aabb.expand(vertex.position);
+    }
+
+    if (!aabb.isValid())
+    {
+      aabb.min = glm::vec3(0.0f);
+      aabb.max = glm::vec3(0.0f);
+    }
+
+    // The sphere is centered on the box, so it is not minimal but it is cheap and stable
+    boundingSphere.center = aabb.getCenter();
+    boundingSphere.radius = 0.0f;
+
+    for (const MeshVertex& vertex : vertices)
+    {
+      boundingSphere.radius = std::max(boundingSphere.radius, glm::distance(boundingSphere.center, vertex.position));
+    }
+  }
+
 
   Plane::Plane()
   {
@@ -174,6 +226,8 @@ namespace Lotus
     {
       0, 1, 2, 2, 3, 0
     };
+
+    computeBounds();
   }
 
   Cube::Cube()
@@ -220,6 +274,8 @@ namespace Lotus
       16, 17, 18, 18, 19, 16,
       20, 21, 22, 22, 23, 20
     };
+
+    computeBounds();
   }
 
   Sphere::Sphere()
@@ -286,5 +342,7 @@ namespace Lotus
         }
       }
     }
+
+    computeBounds();
   }
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <vector>
 #include <unordered_map>
 #include "../math/types.h"
+#include "../math/bounds.h"
+#include "resource_id.h"
 
 namespace Lotus
 {
@@ -29,8 +31,15 @@ namespace Lotus
       Sphere
     };
 
+    // Lower detail version of the mesh, used from the given camera distance on
+    struct LOD
+    {
+      std::shared_ptr<Mesh> mesh;
+      float distance;
+    };
+
     Mesh() = default;
-    Mesh(const Mesh& other) : vertices(other.vertices), indices(other.indices) {}
+    Mesh(const Mesh& other) : vertices(other.vertices), indices(other.indices), lods(other.lods), aabb(other.aabb), boundingSphere(other.boundingSphere) {}
     ~Mesh();
     
     const std::vector<MeshVertex>& getVertices() const { return vertices; }
@@ -38,12 +47,32 @@ namespace Lotus
 
     uint32_t getIndicesCount() { return indices.size(); }
 
+    // Ordered by increasing distance, the mesh itself is the level used below the first distance
+    const std::vector<LOD>& getLODs() const { return lods; }
+
+    uint32_t getResourceID() const { return resourceID.get(); }
+
+    const AABB& getAABB() const { return aabb; }
+    const BoundingSphere& getBoundingSphere() const { return boundingSphere; }
+
   protected:
     Mesh(const std::string& filePath, bool flipUVs = false);
     Mesh(PrimitiveType type);
+    Mesh(std::vector<MeshVertex> meshVertices, std::vector<unsigned int> meshIndices);
+
+    void computeBounds();
+
+    void setLODs(std::vector<LOD> meshLODs);
 
     std::vector<MeshVertex> vertices;
     std::vector<unsigned int> indices;
+
+    std::vector<LOD> lods;
+
+    AABB aabb;
+    BoundingSphere boundingSphere;
+
+    ResourceID<Mesh> resourceID;
   };
 
   class Plane : public Mesh
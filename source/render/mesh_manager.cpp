@@ -1,5 +1,9 @@
 #include "mesh_manager.h"
 
+#include <algorithm>
+#include "mesh_simplifier.h"
+#include "../util/log.h"
+
 namespace Lotus
 {
 
@@ -39,25 +43,129 @@ namespace Lotus
   }
 
   std::shared_ptr<Mesh> MeshManager::loadMesh(const std::filesystem::path& filePath, bool flipUVs) noexcept
+  {
+    LoadOptions options;
+    options.flipUVs = flipUVs;
+
+    return loadMesh(filePath, options);
+  }
+
+  std::shared_ptr<Mesh> MeshManager::loadMesh(const std::filesystem::path& filePath, const std::vector<LODFile>& lodFiles, bool flipUVs) noexcept
+  {
+    LoadOptions options;
+    options.flipUVs = flipUVs;
+    options.lodFiles = lodFiles;
+
+    return loadMesh(filePath, options);
+  }
+
+  std::shared_ptr<Mesh> MeshManager::loadMesh(const std::filesystem::path& filePath, const LoadOptions& options) noexcept
   {
     const std::string& stringPath = filePath.string();
     
     // In case there already existed a loaded mesh with the given path referenced by the meshes map
-    // it is returned immediately
+    // it is reused, only getting its LODs if it has none yet
     auto it = meshMap.find(stringPath);
 
+    std::shared_ptr<Mesh> mesh;
+
     if (it != meshMap.end())
     {
-      return it->second;
+      mesh = it->second;
     }
-    
-    Mesh* meshPtr = new Mesh(stringPath, flipUVs);
-    std::shared_ptr<Mesh> meshSharedPtr = std::shared_ptr<Mesh>(meshPtr);
-    
-    // Before returning the loaded mesh, we add it to the map so future loads are faster
-    meshMap.insert({ stringPath, meshSharedPtr });
+    else
+    {
+      mesh = std::shared_ptr<Mesh>(new Mesh(stringPath, options.flipUVs));
 
-    return meshSharedPtr;
+      if (options.weldVertices)
+      {
+        const size_t initialVerticesCount = mesh->vertices.size();
+
+        MeshOptimizer::weldVertices(mesh->vertices, mesh->indices, options.weldTolerance);
+
+        LOTUS_LOG_INFO("[Mesh Manager Log] Welded mesh {0} ({1} -> {2} vertices)", stringPath, initialVerticesCount, mesh->vertices.size());
+      }
+
+      if (options.optimize)
+      {
+        optimizeMesh(*mesh, stringPath, options);
+      }
+
+      // Before returning the loaded mesh, we add it to the map so future loads are faster
+      meshMap.insert({ stringPath, mesh });
+    }
+
+    if (!mesh->lods.empty() || (options.lodFiles.empty() && options.simplifiedLODs.empty()))
+    {
+      return mesh;
+    }
+
+    std::vector<Mesh::LOD> lods;
+    lods.reserve(options.lodFiles.size() + options.simplifiedLODs.size());
+
+    LoadOptions lodOptions = options;
+    lodOptions.lodFiles.clear();
+    lodOptions.simplifiedLODs.clear();
+
+    for (const LODFile& lodFile : options.lodFiles)
+    {
+      lods.push_back({ loadMesh(lodFile.filePath, lodOptions), lodFile.distance });
+    }
+
+    std::vector<SimplifiedLOD> simplifiedLODs = options.simplifiedLODs;
+    std::sort(simplifiedLODs.begin(), simplifiedLODs.end(), [](const SimplifiedLOD& a, const SimplifiedLOD& b) { return a.distance < b.distance; });
+
+    size_t previousIndicesCount = mesh->indices.size();
+
+    for (const SimplifiedLOD& simplifiedLOD : simplifiedLODs)
+    {
+      MeshSimplificationConfig config;
+      config.triangleRatio = simplifiedLOD.triangleRatio;
+      config.maxError = options.simplificationMaxError;
+
+      std::vector<unsigned int> lodIndices = MeshSimplifier::simplify(mesh->vertices, mesh->indices, config);
+
+      // The error limit can stop the simplification early, levels no simpler than the previous one are dropped
+      if (lodIndices.size() >= previousIndicesCount)
+      {
+        LOTUS_LOG_WARN("[Mesh Manager Warning] LOD at distance {0} of mesh {1} could not be simplified further", simplifiedLOD.distance, filePath.string());
+        continue;
+      }
+
+      previousIndicesCount = lodIndices.size();
+
+      // Only the vertices used by the level are kept
+      std::vector<MeshVertex> lodVertices = mesh->vertices;
+      MeshOptimizer::optimizeVertexFetch(lodVertices, lodIndices);
+
+      std::shared_ptr<Mesh> lodMesh = std::shared_ptr<Mesh>(new Mesh(std::move(lodVertices), std::move(lodIndices)));
+
+      if (options.optimize)
+      {
+        optimizeMesh(*lodMesh, stringPath + " (LOD at distance " + std::to_string(simplifiedLOD.distance) + ")", options);
+      }
+
+      lods.push_back({ lodMesh, simplifiedLOD.distance });
+    }
+
+    mesh->setLODs(std::move(lods));
+
+    return mesh;
+  }
+
+  void MeshManager::optimizeMesh(Mesh& mesh, const std::string& name, const LoadOptions& options) noexcept
+  {
+    const VertexCacheStatistics initialStatistics = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+    MeshOptimizer::optimize(mesh.vertices, mesh.indices, options.overdrawThreshold);
+
+    const VertexCacheStatistics statistics = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+    // Vertices not used by any triangle are dropped, which can shrink the bounds
+    mesh.computeBounds();
+
+    LOTUS_LOG_INFO("[Mesh Manager Log] Optimized mesh {0} (ACMR = {1:.3f} -> {2:.3f}, ATVR = {3:.3f} -> {4:.3f})",
+        name, initialStatistics.acmr, statistics.acmr, initialStatistics.atvr, statistics.atvr);
   }
 
   void MeshManager::cleanUnusedMeshes() noexcept
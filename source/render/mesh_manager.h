@@ -3,8 +3,10 @@
 #include <memory>
 #include <filesystem>
 #include <unordered_map>
+#include <vector>
 
 #include "mesh.h"
+#include "mesh_optimizer.h"
 
 namespace Lotus
 {
@@ -13,6 +15,36 @@ namespace Lotus
   public:
     using MeshMap = std::unordered_map<std::string, std::shared_ptr<Mesh>>;
 
+    // Level of detail loaded from its own file, see Mesh::LOD
+    struct LODFile
+    {
+      std::filesystem::path filePath;
+      float distance;
+    };
+
+    // Level of detail generated by simplifying the mesh down to a ratio of its triangles, see MeshSimplifier
+    struct SimplifiedLOD
+    {
+      float triangleRatio;
+      float distance;
+    };
+
+    struct LoadOptions
+    {
+      bool flipUVs = false;
+      std::vector<LODFile> lodFiles;
+      std::vector<SimplifiedLOD> simplifiedLODs;
+      float simplificationMaxError = 0.05f;
+
+      // Merges vertices with nearly equal attributes, see MeshOptimizer::weldVertices
+      bool weldVertices = true;
+      VertexWeldTolerance weldTolerance;
+
+      // Reorders triangles and vertices for the vertex cache, overdraw and vertex fetch, see MeshOptimizer
+      bool optimize = false;
+      float overdrawThreshold = 1.05f;
+    };
+
     MeshManager(MeshManager const&) = delete;
     
     MeshManager& operator=(MeshManager const&) = delete;
@@ -25,12 +57,18 @@ namespace Lotus
 
     std::shared_ptr<Mesh> loadMesh(Mesh::PrimitiveType type) noexcept;
     std::shared_ptr<Mesh> loadMesh(const std::filesystem::path& filePath, bool flipUVs = false) noexcept;
+
+    // The LODs are attached the first time the mesh is loaded with them, so it has to happen before the mesh is rendered
+    std::shared_ptr<Mesh> loadMesh(const std::filesystem::path& filePath, const std::vector<LODFile>& lodFiles, bool flipUVs = false) noexcept;
+    std::shared_ptr<Mesh> loadMesh(const std::filesystem::path& filePath, const LoadOptions& options) noexcept;
     
     void cleanUnusedMeshes() noexcept;
 
   private:
     MeshManager() = default;
 
+    void optimizeMesh(Mesh& mesh, const std::string& name, const LoadOptions& options) noexcept;
+
     MeshMap meshMap;
   };
 }
\ No newline at end of file
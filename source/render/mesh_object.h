@@ -2,73 +2,169 @@
 
 #include <iostream>
 #include "../util/log.h"
-#include "../scene/node_3d.h"
+#include "../scene/transform.h"
 #include "mesh.h"
 #include "gpu_mesh.h"
 #include "material.h"
+#include "object_store.h"
+#include "rendering_method.h"
 
 namespace Lotus
 {
-  class MeshObject : public Node3D
+  /*
+    Handle to an object whose state lives in the object store of the renderer that created it.
+    Handles of destroyed objects must not be used anymore
+  */
+  class MeshObject
   {
   friend class TraditionalObjectRenderer;
   friend class IndirectObjectRenderer;
 
   public:
 
-    MeshObject(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material) :
-      meshPtr(mesh),
-      materialPtr(material),
-      meshDirty(false),
-      materialDirty(false),
-      shaderDirty(false)
+    MeshObject(ObjectStore* objectStore, uint32_t handle, RenderingMethod method) :
+      store(objectStore),
+      rendererHandle(handle),
+      renderingMethod(method)
     {
-      LOTUS_ASSERT(mesh != nullptr, "[Mesh Object Error] Mesh pointer cannot be null");
-      LOTUS_ASSERT(material != nullptr, "[Mesh Object Error] Material pointer cannot be null");
+      LOTUS_ASSERT(store->meshes[rendererHandle] != nullptr, "[Mesh Object Error] Mesh pointer cannot be null");
+      LOTUS_ASSERT(store->materials[rendererHandle] != nullptr, "[Mesh Object Error] Material pointer cannot be null");
     }
 
-    const std::shared_ptr<Mesh>& getMesh() const noexcept { return meshPtr; }
-    const std::shared_ptr<Material>& getMaterial() const noexcept { return materialPtr; }
+    const std::shared_ptr<Mesh>& getMesh() const noexcept { return store->meshes[rendererHandle]; }
+    const std::shared_ptr<Material>& getMaterial() const noexcept { return store->materials[rendererHandle]; }
+    RenderingMethod getRenderingMethod() const noexcept { return renderingMethod; }
 
-    void setMesh(std::shared_ptr<Mesh> mesh) noexcept
+    void setMesh(const std::shared_ptr<Mesh>& mesh) noexcept
     {
       LOTUS_ASSERT(mesh != nullptr, "[Mesh Object Error] Mesh pointer cannot be null");
       
-      if (mesh == meshPtr)
+      if (mesh == getMesh())
       {
         LOTUS_LOG_WARN("[Mesh Object Warning] Tried to set mesh that is already being used");
         return;
       }
 
-      meshPtr = mesh;
-      meshDirty = true;
+      store->meshes[rendererHandle] = mesh;
+      store->markDirty(rendererHandle, ObjectStore::MeshDirty);
     }
     
-    void setMaterial(std::shared_ptr<Material> material) noexcept
+    void setMaterial(const std::shared_ptr<Material>& material) noexcept
     {
       LOTUS_ASSERT(material != nullptr, "[Mesh Object Error] Material pointer cannot be null");
       
-      if (material == materialPtr)
+      if (material == getMaterial())
       {
         LOTUS_LOG_WARN("[Mesh Object Warning] Tried to set same material as the object's");
         return;
       }
 
-      if (material->getType() != materialPtr->getType())
+      uint8_t flags = ObjectStore::MaterialDirty;
+
+      if (material->getType() != getMaterial()->getType())
       {
-        shaderDirty = true;
+        flags |= ObjectStore::ShaderDirty;
       }
 
-      materialPtr = material;
-      materialDirty = true;
+      store->materials[rendererHandle] = material;
+      store->markDirty(rendererHandle, flags);
+    }
+
+    Transform getTransform() const
+    {
+      return Transform(getLocalTranslation(), getLocalRotation(), getLocalScale());
+    }
+
+    glm::vec3 getLocalTranslation() const
+    {
+      return store->translations[rendererHandle];
+    }
+
+    glm::fquat getLocalRotation() const
+    {
+      return store->rotations[rendererHandle];
+    }
+
+    glm::vec3 getLocalScale() const
+    {
+      return store->scales[rendererHandle];
+    }
+
+    glm::mat4 getModelMatrix() const
+    {
+      return store->getModelMatrix(rendererHandle);
+    }
+
+    void setTransform(const Transform& newTransform)
+    {
+      store->translations[rendererHandle] = newTransform.getLocalTranslation();
+      store->rotations[rendererHandle] = newTransform.getLocalRotation();
+      store->scales[rendererHandle] = newTransform.getLocalScale();
+      store->markDirty(rendererHandle, ObjectStore::TransformDirty);
+    }
+
+    void translate(glm::vec3 translation)
+    {
+      store->translations[rendererHandle] += translation;
+      store->markDirty(rendererHandle, ObjectStore::TransformDirty);
+    }
+
+    void setTranslation(const glm::vec3 translation)
+    {
+      store->translations[rendererHandle] = translation;
+      store->markDirty(rendererHandle, ObjectStore::TransformDirty);
+    }
+
+    void scale(float scale)
+    {
+      store->scales[rendererHandle] *= scale;
+      store->markDirty(rendererHandle, ObjectStore::TransformDirty);
+    }
+
+    void scale(glm::vec3 scale)
+    {
+      store->scales[rendererHandle] *= scale;
+      store->markDirty(rendererHandle, ObjectStore::TransformDirty);
+    }
+
+    void setScale(const glm::vec3& scale)
+    {
+      store->scales[rendererHandle] = scale;
+      store->markDirty(rendererHandle, ObjectStore::TransformDirty);
+    }
+    
+    void rotate(glm::vec3 axis, float angle)
+    {
+      store->rotations[rendererHandle] = glm::angleAxis(angle, axis) * store->rotations[rendererHandle];
+      store->markDirty(rendererHandle, ObjectStore::TransformDirty);
+    }
+
+    void setRotation(const glm::fquat& rotation)
+    {
+      store->rotations[rendererHandle] = rotation;
+      store->markDirty(rendererHandle, ObjectStore::TransformDirty);
+    }
+
+    glm::vec3 getUpVector() const
+    {
+      return glm::rotate(getLocalRotation(), glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    
+    glm::vec3 getRightVector() const
+    {
+      return glm::rotate(getLocalRotation(), glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+
+    glm::vec3 getFrontVector() const
+    {
+      return glm::rotate(getLocalRotation(), glm::vec3(0.0f, 0.0f, -1.0f));
     }
 
   private:
-    std::shared_ptr<Mesh> meshPtr;
-    std::shared_ptr<Material> materialPtr;
+    ObjectStore* store;
 
-    bool meshDirty;
-    bool materialDirty;
-    bool shaderDirty;
+    // Index of the object inside the renderer that created it
+    uint32_t rendererHandle;
+    RenderingMethod renderingMethod;
   };
 }
\ No newline at end of file
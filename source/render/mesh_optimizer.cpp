@@ -0,0 +1,509 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace Lotus
+{
+
+  void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices, size_t verticesCount, uint32_t cacheSize)
+  {
+    std::vector<uint32_t> clusterOffsets;
+    optimizeVertexCache(indices, verticesCount, cacheSize, clusterOffsets);
+  }
+
+  void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices, size_t verticesCount, uint32_t cacheSize, std::vector<uint32_t>& clusterOffsets)
+  {
+    constexpr uint32_t NoVertex = std::numeric_limits<uint32_t>::max();
+
+    const uint32_t trianglesCount = static_cast<uint32_t>(indices.size() / 3);
+
+    clusterOffsets.clear();
+
+    if (trianglesCount == 0)
+    {
+      return;
+    }
+
+    Adjacency adjacency = buildAdjacency(indices, verticesCount);
+
+    // Triangles not emitted yet around each vertex
+    std::vector<uint32_t> liveTriangles(verticesCount);
+
+    for (size_t vertex = 0; vertex < verticesCount; vertex++)
+    {
+      liveTriangles[vertex] = adjacency.offsets[vertex + 1] - adjacency.offsets[vertex];
+    }
+
+    // A vertex is in the FIFO cache while less than cacheSize vertices were transformed after it
+    std::vector<uint32_t> cacheTimestamps(verticesCount, 0);
+    uint32_t timestamp = cacheSize + 1;
+
+    std::vector<bool> emitted(trianglesCount, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    uint32_t cursor = 0;
+    uint32_t fanningVertex = indices[0];
+
+    clusterOffsets.push_back(0);
+
+    while (fanningVertex != NoVertex)
+    {
+      candidates.clear();
+
+      // Emit every remaining triangle around the fanning vertex
+      for (uint32_t i = adjacency.offsets[fanningVertex]; i < adjacency.offsets[fanningVertex + 1]; i++)
+      {
+        const uint32_t triangle = adjacency.triangles[i];
+
+        if (emitted[triangle])
+        {
+          continue;
+        }
+
+        for (int corner = 0; corner < 3; corner++)
+        {
+          const uint32_t vertex = indices[triangle * 3 + corner];
+
+          result.push_back(vertex);
+          deadEnds.push_back(vertex);
+          candidates.push_back(vertex);
+          liveTriangles[vertex]--;
+
+          if (timestamp - cacheTimestamps[vertex] > cacheSize)
+          {
+            cacheTimestamps[vertex] = timestamp++;
+          }
+        }
+
+        emitted[triangle] = true;
+      }
+
+      // Next fanning vertex among the ones just used, preferring the oldest one still in the cache
+      // after its remaining triangles are emitted, so its triangles are added before it is evicted
+      uint32_t nextVertex = NoVertex;
+      int bestPriority = -1;
+
+      for (uint32_t vertex : candidates)
+      {
+        if (liveTriangles[vertex] == 0)
+        {
+          continue;
+        }
+
+        int priority = 0;
+
+        if (timestamp - cacheTimestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+        {
+          priority = static_cast<int>(timestamp - cacheTimestamps[vertex]);
+        }
+
+        if (priority > bestPriority)
+        {
+          bestPriority = priority;
+          nextVertex = vertex;
+        }
+      }
+
+      if (nextVertex != NoVertex)
+      {
+        fanningVertex = nextVertex;
+        continue;
+      }
+
+      // Dead end, the walk restarts from a recently used vertex or from the next vertex in input order
+      // and a new cluster of triangles begins
+      while (!deadEnds.empty() && nextVertex == NoVertex)
+      {
+        const uint32_t vertex = deadEnds.back();
+        deadEnds.pop_back();
+
+        if (liveTriangles[vertex] > 0)
+        {
+          nextVertex = vertex;
+        }
+      }
+
+      while (nextVertex == NoVertex && cursor < verticesCount)
+      {
+        if (liveTriangles[cursor] > 0)
+        {
+          nextVertex = cursor;
+        }
+
+        cursor++;
+      }
+
+      if (nextVertex != NoVertex)
+      {
+        clusterOffsets.push_back(static_cast<uint32_t>(result.size() / 3));
+      }
+
+      fanningVertex = nextVertex;
+    }
+
+    indices.swap(result);
+  }
+
+  void MeshOptimizer::optimizeOverdraw(
+      const std::vector<MeshVertex>& vertices,
+      std::vector<unsigned int>& indices,
+      const std::vector<uint32_t>& clusterOffsets,
+      float threshold,
+      uint32_t cacheSize)
+  {
+    const uint32_t trianglesCount = static_cast<uint32_t>(indices.size() / 3);
+
+    if (trianglesCount == 0)
+    {
+      return;
+    }
+
+    std::vector<uint32_t> cacheTimestamps(vertices.size(), 0);
+    uint32_t timestamp = cacheSize + 1;
+
+    // Clusters given by the vertex cache order are split where their ACMR so far is already low,
+    // so the sort has more freedom without making the cache efficiency much worse
+    std::vector<uint32_t> clusters;
+
+    for (size_t i = 0; i < clusterOffsets.size(); i++)
+    {
+      const uint32_t first = clusterOffsets[i];
+      const uint32_t last = i + 1 < clusterOffsets.size() ? clusterOffsets[i + 1] : trianglesCount;
+
+      const float clusterACMR = static_cast<float>(countCacheMisses(indices, first, last, cacheTimestamps, timestamp, cacheSize)) / (last - first);
+
+      clusters.push_back(first);
+
+      uint32_t clusterStart = first;
+      uint32_t misses = 0;
+      timestamp += cacheSize + 1;
+
+      for (uint32_t triangle = first; triangle + 1 < last; triangle++)
+      {
+        for (int corner = 0; corner < 3; corner++)
+        {
+          const uint32_t vertex = indices[triangle * 3 + corner];
+
+          if (timestamp - cacheTimestamps[vertex] > cacheSize)
+          {
+            cacheTimestamps[vertex] = timestamp++;
+            misses++;
+          }
+        }
+
+        if (static_cast<float>(misses) / (triangle + 1 - clusterStart) <= threshold * clusterACMR)
+        {
+          clusterStart = triangle + 1;
+          misses = 0;
+          timestamp += cacheSize + 1;
+
+          clusters.push_back(clusterStart);
+        }
+      }
+    }
+
+    // Clusters facing away from the mesh center are the most likely to occlude the rest of the mesh
+    std::vector<float> clusterSortKeys(clusters.size());
+    std::vector<glm::vec3> clusterCentroids(clusters.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormals(clusters.size(), glm::vec3(0.0f));
+    std::vector<float> clusterAreas(clusters.size(), 0.0f);
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+
+    for (size_t i = 0; i < clusters.size(); i++)
+    {
+      const uint32_t last = i + 1 < clusters.size() ? clusters[i + 1] : trianglesCount;
+
+      for (uint32_t triangle = clusters[i]; triangle < last; triangle++)
+      {
+        const glm::vec3& a = vertices[indices[triangle * 3]].position;
+        const glm::vec3& b = vertices[indices[triangle * 3 + 1]].position;
+        const glm::vec3& c = vertices[indices[triangle * 3 + 2]].position;
+
+        // Twice the area weighted normal of the triangle
+        const glm::vec3 normal = glm::cross(b - a, c - a);
+        const float area = glm::length(normal);
+
+        clusterCentroids[i] += area * (a + b + c) / 3.0f;
+        clusterNormals[i] += normal;
+        clusterAreas[i] += area;
+      }
+
+      meshCentroid += clusterCentroids[i];
+      meshArea += clusterAreas[i];
+    }
+
+    meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+    for (size_t i = 0; i < clusters.size(); i++)
+    {
+      const float normalLength = glm::length(clusterNormals[i]);
+
+      if (clusterAreas[i] <= 0.0f || normalLength <= 0.0f)
+      {
+        clusterSortKeys[i] = 0.0f;
+        continue;
+      }
+
+      clusterSortKeys[i] = glm::dot(clusterCentroids[i] / clusterAreas[i] - meshCentroid, clusterNormals[i] / normalLength);
+    }
+
+    std::vector<uint32_t> clusterOrder(clusters.size());
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&clusterSortKeys](uint32_t a, uint32_t b) { return clusterSortKeys[a] > clusterSortKeys[b]; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    for (uint32_t cluster : clusterOrder)
+    {
+      const uint32_t last = cluster + 1 < clusters.size() ? clusters[cluster + 1] : trianglesCount;
+
+      result.insert(result.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + last * 3);
+    }
+
+    indices.swap(result);
+  }
+
+  void MeshOptimizer::optimizeVertexFetch(std::vector<MeshVertex>& vertices, std::vector<unsigned int>& indices)
+  {
+    constexpr unsigned int Unused = std::numeric_limits<unsigned int>::max();
+
+    std::vector<unsigned int> remap(vertices.size(), Unused);
+    std::vector<MeshVertex> fetchedVertices;
+    fetchedVertices.reserve(vertices.size());
+
+    for (unsigned int& index : indices)
+    {
+      if (remap[index] == Unused)
+      {
+        remap[index] = static_cast<unsigned int>(fetchedVertices.size());
+        fetchedVertices.push_back(vertices[index]);
+      }
+
+      index = remap[index];
+    }
+
+    vertices.swap(fetchedVertices);
+  }
+
+  void MeshOptimizer::optimize(std::vector<MeshVertex>& vertices, std::vector<unsigned int>& indices, float overdrawThreshold, uint32_t cacheSize)
+  {
+    std::vector<uint32_t> clusterOffsets;
+
+    optimizeVertexCache(indices, vertices.size(), cacheSize, clusterOffsets);
+    optimizeOverdraw(vertices, indices, clusterOffsets, overdrawThreshold, cacheSize);
+    optimizeVertexFetch(vertices, indices);
+  }
+
+  void MeshOptimizer::weldVertices(std::vector<MeshVertex>& vertices, std::vector<unsigned int>& indices, const VertexWeldTolerance& tolerance)
+  {
+    constexpr uint32_t NoVertex = std::numeric_limits<uint32_t>::max();
+
+    if (vertices.empty())
+    {
+      return;
+    }
+
+    glm::vec3 minimum = vertices[0].position;
+    glm::vec3 maximum = vertices[0].position;
+
+    for (const MeshVertex& vertex : vertices)
+    {
+      minimum = glm::min(minimum, vertex.position);
+      maximum = glm::max(maximum, vertex.position);
+    }
+
+    const glm::vec3 extents = maximum - minimum;
+    const float positionTolerance = std::max(tolerance.position * std::max(extents.x, std::max(extents.y, extents.z)), std::numeric_limits<float>::min());
+
+    // Cells twice as large as the tolerance, so the vertices close enough to a position are in at most two cells per axis
+    const float cellSize = 2.0f * positionTolerance;
+
+    auto getCell = [&minimum, cellSize](const glm::vec3& position)
+    {
+      return glm::ivec3(glm::floor((position - minimum) / cellSize));
+    };
+
+    // Cells are packed in 21 bits per axis, colliding cells only add candidates that are then rejected
+    auto getCellKey = [](const glm::ivec3& cell)
+    {
+      return ((static_cast<uint64_t>(cell.x) & 0x1FFFFF) << 42) | ((static_cast<uint64_t>(cell.y) & 0x1FFFFF) << 21) | (static_cast<uint64_t>(cell.z) & 0x1FFFFF);
+    };
+
+    auto isWeldable = [&tolerance, positionTolerance](const MeshVertex& a, const MeshVertex& b)
+    {
+      // Mirrored tangent frames can't be merged even when the rest of the attributes match
+      const bool sameHandedness = (glm::dot(glm::cross(a.normal, a.tangent), a.bitangent) < 0.0f) == (glm::dot(glm::cross(b.normal, b.tangent), b.bitangent) < 0.0f);
+
+      const glm::vec3 positionDifference = glm::abs(a.position - b.position);
+      const glm::vec2 uvDifference = glm::abs(a.uv - b.uv);
+
+      return std::max(positionDifference.x, std::max(positionDifference.y, positionDifference.z)) <= positionTolerance
+          && glm::length(a.normal - b.normal) <= tolerance.normal
+          && std::max(uvDifference.x, uvDifference.y) <= tolerance.uv
+          && sameHandedness;
+    };
+
+    // Kept vertices are linked in lists starting at their cell
+    std::unordered_map<uint64_t, uint32_t> cellHeads;
+    cellHeads.reserve(vertices.size());
+
+    std::vector<uint32_t> nextInCell;
+    std::vector<unsigned int> remap(vertices.size());
+    std::vector<MeshVertex> weldedVertices;
+    weldedVertices.reserve(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+      const MeshVertex& vertex = vertices[i];
+
+      const glm::ivec3 firstCell = getCell(vertex.position - positionTolerance);
+      const glm::ivec3 lastCell = getCell(vertex.position + positionTolerance);
+
+      uint32_t match = NoVertex;
+
+      for (int x = firstCell.x; x <= lastCell.x && match == NoVertex; x++)
+      {
+        for (int y = firstCell.y; y <= lastCell.y && match == NoVertex; y++)
+        {
+          for (int z = firstCell.z; z <= lastCell.z && match == NoVertex; z++)
+          {
+            auto it = cellHeads.find(getCellKey(glm::ivec3(x, y, z)));
+
+            for (uint32_t candidate = it != cellHeads.end() ? it->second : NoVertex; candidate != NoVertex; candidate = nextInCell[candidate])
+            {
+              if (isWeldable(weldedVertices[candidate], vertex))
+              {
+                match = candidate;
+                break;
+              }
+            }
+          }
+        }
+      }
+
+      if (match == NoVertex)
+      {
+        match = static_cast<uint32_t>(weldedVertices.size());
+        weldedVertices.push_back(vertex);
+
+        auto [it, inserted] = cellHeads.try_emplace(getCellKey(getCell(vertex.position)), match);
+        nextInCell.push_back(inserted ? NoVertex : it->second);
+        it->second = match;
+      }
+
+      remap[i] = match;
+    }
+
+    size_t keptIndices = 0;
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+      const unsigned int a = remap[indices[i]];
+      const unsigned int b = remap[indices[i + 1]];
+      const unsigned int c = remap[indices[i + 2]];
+
+      if (a == b || b == c || a == c)
+      {
+        continue;
+      }
+
+      indices[keptIndices++] = a;
+      indices[keptIndices++] = b;
+      indices[keptIndices++] = c;
+    }
+
+    indices.resize(keptIndices);
+    vertices.swap(weldedVertices);
+  }
+
+  VertexCacheStatistics MeshOptimizer::analyzeVertexCache(const std::vector<unsigned int>& indices, size_t verticesCount, uint32_t cacheSize)
+  {
+    VertexCacheStatistics statistics;
+
+    const uint32_t trianglesCount = static_cast<uint32_t>(indices.size() / 3);
+
+    if (trianglesCount == 0)
+    {
+      return statistics;
+    }
+
+    std::vector<uint32_t> cacheTimestamps(verticesCount, 0);
+    uint32_t timestamp = 0;
+
+    statistics.transformedVertices = countCacheMisses(indices, 0, trianglesCount, cacheTimestamps, timestamp, cacheSize);
+
+    std::vector<bool> used(verticesCount, false);
+    uint32_t usedVertices = 0;
+
+    for (unsigned int index : indices)
+    {
+      usedVertices += used[index] ? 0 : 1;
+      used[index] = true;
+    }
+
+    statistics.acmr = static_cast<float>(statistics.transformedVertices) / trianglesCount;
+    statistics.atvr = static_cast<float>(statistics.transformedVertices) / usedVertices;
+
+    return statistics;
+  }
+
+  MeshOptimizer::Adjacency MeshOptimizer::buildAdjacency(const std::vector<unsigned int>& indices, size_t verticesCount)
+  {
+    Adjacency adjacency;
+    adjacency.offsets.assign(verticesCount + 1, 0);
+    adjacency.triangles.resize(indices.size());
+
+    for (unsigned int index : indices)
+    {
+      adjacency.offsets[index + 1]++;
+    }
+
+    std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+    std::vector<uint32_t> filled(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+      adjacency.triangles[filled[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    return adjacency;
+  }
+
+  uint32_t MeshOptimizer::countCacheMisses(
+      const std::vector<unsigned int>& indices,
+      uint32_t firstTriangle,
+      uint32_t lastTriangle,
+      std::vector<uint32_t>& cacheTimestamps,
+      uint32_t& timestamp,
+      uint32_t cacheSize)
+  {
+    // Moving the timestamp past the cache size evicts every vertex
+    timestamp += cacheSize + 1;
+
+    uint32_t misses = 0;
+
+    for (uint32_t i = firstTriangle * 3; i < lastTriangle * 3; i++)
+    {
+      const uint32_t vertex = indices[i];
+
+      if (timestamp - cacheTimestamps[vertex] > cacheSize)
+      {
+        cacheTimestamps[vertex] = timestamp++;
+        misses++;
+      }
+    }
+
+    return misses;
+  }
+
+}
\ No newline at end of file
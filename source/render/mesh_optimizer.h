@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "../math/types.h"
+#include "mesh.h"
+
+namespace Lotus
+{
+
+  // Efficiency of an index order for a FIFO post-transform vertex cache
+  struct VertexCacheStatistics
+  {
+    uint32_t transformedVertices = 0;
+    float acmr = 0.0f;   // Average cache miss ratio, transformed vertices per triangle
+    float atvr = 0.0f;   // Average transformed vertex ratio, transformed vertices per used vertex
+  };
+
+  // Largest differences between two vertices merged by MeshOptimizer::weldVertices
+  struct VertexWeldTolerance
+  {
+    float position = 1e-5f;   // Relative to the largest side of the mesh bounds
+    float normal = 1e-3f;     // Distance between the unit normals
+    float uv = 1e-5f;
+  };
+
+  /*
+    Reordering of the triangles and vertices of a mesh for the GPU, without changing what is drawn.
+    Triangles are ordered for the post-transform vertex cache with Tipsify, the resulting clusters
+    are sorted so the ones facing away from the mesh center are drawn first to reduce overdraw, and
+    vertices are placed in the order they are fetched.
+    Source: Sander, Nehab & Barczak, Fast Triangle Reordering for Vertex Locality and Reduced Overdraw
+  */
+  class MeshOptimizer
+  {
+  public:
+    // Vertices kept by the simulated cache, small enough to fit the caches of current GPUs
+    static constexpr uint32_t DefaultCacheSize = 16;
+
+    static void optimizeVertexCache(std::vector<unsigned int>& indices, size_t verticesCount, uint32_t cacheSize = DefaultCacheSize);
+
+    // Same as above, also writing the first triangle of every cluster in clusterOffsets
+    static void optimizeVertexCache(std::vector<unsigned int>& indices, size_t verticesCount, uint32_t cacheSize, std::vector<uint32_t>& clusterOffsets);
+
+    // Clusters are split further while their own ACMR stays under the threshold times the ACMR of the whole cluster
+    static void optimizeOverdraw(
+        const std::vector<MeshVertex>& vertices,
+        std::vector<unsigned int>& indices,
+        const std::vector<uint32_t>& clusterOffsets,
+        float threshold = 1.05f,
+        uint32_t cacheSize = DefaultCacheSize);
+
+    // Keeps the vertices used by the indices, in order of first use, and remaps the indices to them
+    static void optimizeVertexFetch(std::vector<MeshVertex>& vertices, std::vector<unsigned int>& indices);
+
+    // Runs the three passes above in order
+    static void optimize(std::vector<MeshVertex>& vertices, std::vector<unsigned int>& indices, float overdrawThreshold = 1.05f, uint32_t cacheSize = DefaultCacheSize);
+
+    // Merges vertices within the tolerances of an already kept one, found through a hash grid of their positions.
+    // Kept vertices stay in their original order and triangles left without area by the merge are removed
+    static void weldVertices(std::vector<MeshVertex>& vertices, std::vector<unsigned int>& indices, const VertexWeldTolerance& tolerance = {});
+
+    static VertexCacheStatistics analyzeVertexCache(const std::vector<unsigned int>& indices, size_t verticesCount, uint32_t cacheSize = DefaultCacheSize);
+
+  private:
+    // Triangles using each vertex, as ranges of a single array
+    struct Adjacency
+    {
+      std::vector<uint32_t> offsets;
+      std::vector<uint32_t> triangles;
+    };
+
+    static Adjacency buildAdjacency(const std::vector<unsigned int>& indices, size_t verticesCount);
+
+    // Cache misses of the triangles in [firstTriangle, lastTriangle), starting from an empty cache
+    static uint32_t countCacheMisses(
+        const std::vector<unsigned int>& indices,
+        uint32_t firstTriangle,
+        uint32_t lastTriangle,
+        std::vector<uint32_t>& cacheTimestamps,
+        uint32_t& timestamp,
+        uint32_t cacheSize);
+  };
+
+}
\ No newline at end of file
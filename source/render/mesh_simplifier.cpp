@@ -0,0 +1,504 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include "../math/bounds.h"
+
+namespace Lotus
+{
+
+  void MeshSimplifier::Quadric::addPlane(const glm::vec3& normal, float distance, double planeWeight)
+  {
+    const double a = normal.x;
+    const double b = normal.y;
+    const double c = normal.z;
+    const double d = distance;
+
+    a2 += planeWeight * a * a;
+    b2 += planeWeight * b * b;
+    c2 += planeWeight * c * c;
+    d2 += planeWeight * d * d;
+    ab += planeWeight * a * b;
+    ac += planeWeight * a * c;
+    ad += planeWeight * a * d;
+    bc += planeWeight * b * c;
+    bd += planeWeight * b * d;
+    cd += planeWeight * c * d;
+    weight += planeWeight;
+  }
+
+  void MeshSimplifier::Quadric::add(const Quadric& other)
+  {
+    a2 += other.a2;
+    b2 += other.b2;
+    c2 += other.c2;
+    d2 += other.d2;
+    ab += other.ab;
+    ac += other.ac;
+    ad += other.ad;
+    bc += other.bc;
+    bd += other.bd;
+    cd += other.cd;
+    weight += other.weight;
+  }
+
+  double MeshSimplifier::Quadric::getError(const glm::vec3& point) const
+  {
+    if (weight <= 0.0)
+    {
+      return 0.0;
+    }
+
+    const double x = point.x;
+    const double y = point.y;
+    const double z = point.z;
+
+    double error = a2 * x * x + b2 * y * y + c2 * z * z + d2 + 2.0 * (ab * x * y + ac * x * z + ad * x + bc * y * z + bd * y + cd * z);
+
+    // Rounding can make the error of a point on all the planes slightly negative
+    return std::max(error, 0.0) / weight;
+  }
+
+  std::vector<unsigned int> MeshSimplifier::simplify(
+      const std::vector<MeshVertex>& vertices,
+      const std::vector<unsigned int>& indices,
+      const MeshSimplificationConfig& config,
+      float* resultError)
+  {
+    std::vector<unsigned int> result = indices;
+
+    const size_t targetIndexCount = static_cast<size_t>(indices.size() / 3 * std::clamp(config.triangleRatio, 0.0f, 1.0f)) * 3;
+    const double maxCost = static_cast<double>(config.maxError) * config.maxError;
+
+    double maxError = 0.0;
+
+    if (resultError)
+    {
+      *resultError = 0.0f;
+    }
+
+    if (vertices.empty() || result.size() <= targetIndexCount)
+    {
+      return result;
+    }
+
+    // Positions are normalized by the largest side of the bounds, so errors don't depend on the mesh size
+    AABB bounds;
+
+    for (const MeshVertex& vertex : vertices)
+    {
+      bounds.expand(vertex.position);
+    }
+
+    const glm::vec3 size = bounds.max - bounds.min;
+    const float largestSide = std::max({ size.x, size.y, size.z });
+    const float scale = largestSide > 0.0f ? 1.0f / largestSide : 1.0f;
+
+    std::vector<glm::vec3> positions(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+      positions[i] = (vertices[i].position - bounds.min) * scale;
+    }
+
+    // Vertices with the same position are grouped under a root, and linked in a circular list of wedges
+    std::vector<uint32_t> positionRoots(vertices.size());
+    std::vector<uint32_t> nextWedges(vertices.size());
+
+    std::vector<uint32_t> sortedVertices(vertices.size());
+    std::iota(sortedVertices.begin(), sortedVertices.end(), 0);
+
+    std::sort(sortedVertices.begin(), sortedVertices.end(), [&positions](uint32_t a, uint32_t b)
+    {
+      const glm::vec3& pa = positions[a];
+      const glm::vec3& pb = positions[b];
+
+      return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+    });
+
+    for (size_t first = 0, last = 0; first < sortedVertices.size(); first = last)
+    {
+      last = first + 1;
+
+      while (last < sortedVertices.size() && positions[sortedVertices[last]] == positions[sortedVertices[first]])
+      {
+        last++;
+      }
+
+      for (size_t i = first; i < last; i++)
+      {
+        positionRoots[sortedVertices[i]] = sortedVertices[first];
+        nextWedges[sortedVertices[i]] = sortedVertices[i + 1 < last ? i + 1 : first];
+      }
+    }
+
+    const size_t trianglesCount = result.size() / 3;
+    size_t liveTrianglesCount = trianglesCount;
+
+    std::vector<bool> removed(trianglesCount, false);
+    std::vector<std::vector<uint32_t>> rootTriangles(vertices.size());
+    std::vector<Quadric> quadrics(vertices.size());
+
+    for (uint32_t t = 0; t < trianglesCount; t++)
+    {
+      const uint32_t r0 = positionRoots[result[t * 3 + 0]];
+      const uint32_t r1 = positionRoots[result[t * 3 + 1]];
+      const uint32_t r2 = positionRoots[result[t * 3 + 2]];
+
+      // Triangles with repeated positions have no area to keep
+      if (r0 == r1 || r1 == r2 || r0 == r2)
+      {
+        removed[t] = true;
+        liveTrianglesCount--;
+        continue;
+      }
+
+      rootTriangles[r0].push_back(t);
+      rootTriangles[r1].push_back(t);
+      rootTriangles[r2].push_back(t);
+
+      const glm::vec3& p0 = positions[r0];
+      const glm::vec3& p1 = positions[r1];
+      const glm::vec3& p2 = positions[r2];
+
+      glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+      const float normalLength = glm::length(normal);
+
+      if (normalLength <= 0.0f)
+      {
+        continue;
+      }
+
+      normal /= normalLength;
+
+      // Planes are weighted by the triangle area
+      quadrics[r0].addPlane(normal, -glm::dot(normal, p0), 0.5 * normalLength);
+      quadrics[r1].addPlane(normal, -glm::dot(normal, p0), 0.5 * normalLength);
+      quadrics[r2].addPlane(normal, -glm::dot(normal, p0), 0.5 * normalLength);
+    }
+
+    // Open borders get planes perpendicular to their triangle, so they can only slide along themselves
+    std::vector<bool> borderRoots(vertices.size(), false);
+
+    for (const Edge& edge : collectEdges(result, removed, positionRoots))
+    {
+      if (!edge.border)
+      {
+        continue;
+      }
+
+      borderRoots[edge.u] = true;
+      borderRoots[edge.v] = true;
+
+      for (uint32_t t : rootTriangles[edge.u])
+      {
+        uint32_t r[3] = { positionRoots[result[t * 3 + 0]], positionRoots[result[t * 3 + 1]], positionRoots[result[t * 3 + 2]] };
+
+        bool hasV = r[0] == edge.v || r[1] == edge.v || r[2] == edge.v;
+
+        if (!hasV)
+        {
+          continue;
+        }
+
+        const glm::vec3& pu = positions[edge.u];
+        const glm::vec3& pv = positions[edge.v];
+        const glm::vec3 faceNormal = glm::cross(positions[r[1]] - positions[r[0]], positions[r[2]] - positions[r[0]]);
+        glm::vec3 borderNormal = glm::cross(pv - pu, faceNormal);
+        const float borderNormalLength = glm::length(borderNormal);
+
+        if (borderNormalLength > 0.0f)
+        {
+          borderNormal /= borderNormalLength;
+
+          const glm::vec3 edgeVector = pv - pu;
+          const double edgeWeight = BorderWeight * glm::dot(edgeVector, edgeVector);
+
+          quadrics[edge.u].addPlane(borderNormal, -glm::dot(borderNormal, pu), edgeWeight);
+          quadrics[edge.v].addPlane(borderNormal, -glm::dot(borderNormal, pu), edgeWeight);
+        }
+
+        break;
+      }
+    }
+
+    /*
+      Every wedge of the removed position is replaced by the closest wedge of the kept one. Attributes
+      are continuous across the surface, so the collapse is only penalized when the wedges don't shift
+      their attributes alike, which happens when a seam or a crease would be broken
+    */
+    auto matchWedges = [&](uint32_t from, uint32_t to, std::vector<std::pair<uint32_t, uint32_t>>* matches)
+    {
+      double cost = 0.0;
+      uint32_t fromWedge = from;
+
+      glm::vec3 firstNormalShift(0.0f);
+      glm::vec2 firstUVShift(0.0f);
+
+      do
+      {
+        double bestDistance = std::numeric_limits<double>::max();
+        uint32_t bestWedge = to;
+        uint32_t toWedge = to;
+
+        do
+        {
+          const glm::vec3 normalOffset = vertices[toWedge].normal - vertices[fromWedge].normal;
+          const glm::vec2 uvOffset = vertices[toWedge].uv - vertices[fromWedge].uv;
+
+          const double distance = config.normalWeight * glm::dot(normalOffset, normalOffset) + config.uvWeight * glm::dot(uvOffset, uvOffset);
+
+          if (distance < bestDistance)
+          {
+            bestDistance = distance;
+            bestWedge = toWedge;
+          }
+
+          toWedge = nextWedges[toWedge];
+        }
+        while (toWedge != to);
+
+        if (matches)
+        {
+          matches->push_back({ fromWedge, bestWedge });
+        }
+
+        const glm::vec3 normalShift = vertices[bestWedge].normal - vertices[fromWedge].normal;
+        const glm::vec2 uvShift = vertices[bestWedge].uv - vertices[fromWedge].uv;
+
+        if (fromWedge == from)
+        {
+          firstNormalShift = normalShift;
+          firstUVShift = uvShift;
+        }
+        else
+        {
+          const glm::vec3 normalDifference = normalShift - firstNormalShift;
+          const glm::vec2 uvDifference = uvShift - firstUVShift;
+
+          cost = std::max(cost, static_cast<double>(config.normalWeight * glm::dot(normalDifference, normalDifference) + config.uvWeight * glm::dot(uvDifference, uvDifference)));
+        }
+
+        fromWedge = nextWedges[fromWedge];
+      }
+      while (fromWedge != from);
+
+      return cost;
+    };
+
+    // Moving the position must not turn any of the remaining triangles around it upside down
+    auto keepsOrientation = [&](uint32_t from, uint32_t to)
+    {
+      for (uint32_t t : rootTriangles[from])
+      {
+        if (removed[t])
+        {
+          continue;
+        }
+
+        glm::vec3 before[3];
+        glm::vec3 after[3];
+        bool collapsed = false;
+
+        for (int k = 0; k < 3; k++)
+        {
+          const uint32_t root = positionRoots[result[t * 3 + k]];
+
+          collapsed |= root == to;
+          before[k] = positions[root];
+          after[k] = root == from ? positions[to] : positions[root];
+        }
+
+        if (collapsed)
+        {
+          continue;
+        }
+
+        const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+        const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+        if (glm::dot(normalBefore, normalAfter) <= 0.0f)
+        {
+          return false;
+        }
+      }
+
+      return true;
+    };
+
+    std::vector<Collapse> collapses;
+    std::vector<bool> locked(vertices.size());
+    std::vector<std::pair<uint32_t, uint32_t>> wedgeMatches;
+
+    // Every pass collapses the cheapest edges, each position taking part in one collapse at most
+    while (liveTrianglesCount * 3 > targetIndexCount)
+    {
+      collapses.clear();
+
+      for (const Edge& edge : collectEdges(result, removed, positionRoots))
+      {
+        Collapse best = { 0, 0, std::numeric_limits<double>::max(), 0.0 };
+
+        for (auto [from, to] : { std::pair(edge.u, edge.v), std::pair(edge.v, edge.u) })
+        {
+          // Border positions can only move along the border
+          if (borderRoots[from] && !edge.border)
+          {
+            continue;
+          }
+
+          Quadric quadric = quadrics[from];
+          quadric.add(quadrics[to]);
+
+          const double error = quadric.getError(positions[to]);
+          const double cost = error + matchWedges(from, to, nullptr);
+
+          if (cost < best.cost)
+          {
+            best = { from, to, cost, error };
+          }
+        }
+
+        if (best.cost <= maxCost)
+        {
+          collapses.push_back(best);
+        }
+      }
+
+      std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+      std::fill(locked.begin(), locked.end(), false);
+
+      size_t passCollapsesCount = 0;
+
+      for (const Collapse& collapse : collapses)
+      {
+        if (liveTrianglesCount * 3 <= targetIndexCount)
+        {
+          break;
+        }
+
+        if (locked[collapse.from] || locked[collapse.to] || !keepsOrientation(collapse.from, collapse.to))
+        {
+          continue;
+        }
+
+        wedgeMatches.clear();
+        matchWedges(collapse.from, collapse.to, &wedgeMatches);
+
+        for (uint32_t t : rootTriangles[collapse.from])
+        {
+          if (removed[t])
+          {
+            continue;
+          }
+
+          uint32_t roots[3];
+
+          for (int k = 0; k < 3; k++)
+          {
+            unsigned int& index = result[t * 3 + k];
+
+            if (positionRoots[index] == collapse.from)
+            {
+              index = std::find_if(wedgeMatches.begin(), wedgeMatches.end(), [index](const auto& match) { return match.first == index; })->second;
+            }
+
+            roots[k] = positionRoots[index];
+          }
+
+          if (roots[0] == roots[1] || roots[1] == roots[2] || roots[0] == roots[2])
+          {
+            removed[t] = true;
+            liveTrianglesCount--;
+          }
+          else
+          {
+            rootTriangles[collapse.to].push_back(t);
+          }
+        }
+
+        rootTriangles[collapse.from].clear();
+        quadrics[collapse.to].add(quadrics[collapse.from]);
+
+        locked[collapse.from] = true;
+        locked[collapse.to] = true;
+
+        maxError = std::max(maxError, collapse.error);
+        passCollapsesCount++;
+      }
+
+      if (passCollapsesCount == 0)
+      {
+        break;
+      }
+    }
+
+    // Triangles left are packed in their original order
+    size_t resultSize = 0;
+
+    for (size_t t = 0; t < trianglesCount; t++)
+    {
+      if (!removed[t])
+      {
+        result[resultSize++] = result[t * 3 + 0];
+        result[resultSize++] = result[t * 3 + 1];
+        result[resultSize++] = result[t * 3 + 2];
+      }
+    }
+
+    result.resize(resultSize);
+
+    if (resultError)
+    {
+      *resultError = static_cast<float>(std::sqrt(maxError));
+    }
+
+    return result;
+  }
+
+  std::vector<MeshSimplifier::Edge> MeshSimplifier::collectEdges(const std::vector<unsigned int>& indices, const std::vector<bool>& removed, const std::vector<uint32_t>& positionRoots)
+  {
+    // Edges are keyed by their sorted roots, an edge used by a single triangle is on an open border
+    std::vector<uint64_t> keys;
+    keys.reserve(indices.size());
+
+    for (size_t t = 0; t < removed.size(); t++)
+    {
+      if (removed[t])
+      {
+        continue;
+      }
+
+      for (int k = 0; k < 3; k++)
+      {
+        const uint32_t a = positionRoots[indices[t * 3 + k]];
+        const uint32_t b = positionRoots[indices[t * 3 + (k + 1) % 3]];
+
+        keys.push_back((static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b));
+      }
+    }
+
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<Edge> edges;
+    edges.reserve(keys.size() / 2);
+
+    for (size_t first = 0, last = 0; first < keys.size(); first = last)
+    {
+      last = first + 1;
+
+      while (last < keys.size() && keys[last] == keys[first])
+      {
+        last++;
+      }
+
+      edges.push_back({ static_cast<uint32_t>(keys[first] >> 32), static_cast<uint32_t>(keys[first]), last - first == 1 });
+    }
+
+    return edges;
+  }
+
+}
\ No newline at end of file
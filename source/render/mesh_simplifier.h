@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "../math/types.h"
+#include "mesh.h"
+
+namespace Lotus
+{
+
+  struct MeshSimplificationConfig
+  {
+    float triangleRatio = 0.5f;   // Fraction of the triangles to keep
+    float maxError = 0.05f;       // Largest error allowed, relative to the largest side of the mesh bounds
+    float normalWeight = 0.01f;   // Cost of changing the normal of a vertex, so creases and seams are kept
+    float uvWeight = 0.01f;       // Cost of changing the UV of a vertex, so texture seams are kept
+  };
+
+  /*
+    Mesh simplification by edge collapses ordered by the quadric error metric.
+    Source: Garland & Heckbert, Surface Simplification Using Quadric Error Metrics
+
+    Vertices with the same position are collapsed together, every attribute vertex of the removed
+    position being replaced by the closest attribute vertex of the kept one. Vertices are never moved,
+    so the simplified indices keep referencing the original vertices
+  */
+  class MeshSimplifier
+  {
+  public:
+
+    // The error reached, relative to the largest side of the mesh bounds, is written in resultError
+    static std::vector<unsigned int> simplify(
+        const std::vector<MeshVertex>& vertices,
+        const std::vector<unsigned int>& indices,
+        const MeshSimplificationConfig& config,
+        float* resultError = nullptr);
+
+  private:
+
+    // Sum of weighted squared distances to a set of planes, stored as the upper half of a symmetric 4x4 matrix
+    struct Quadric
+    {
+      double a2 = 0.0, b2 = 0.0, c2 = 0.0, d2 = 0.0;
+      double ab = 0.0, ac = 0.0, ad = 0.0, bc = 0.0, bd = 0.0, cd = 0.0;
+      double weight = 0.0;
+
+      void addPlane(const glm::vec3& normal, float distance, double planeWeight);
+      void add(const Quadric& other);
+
+      // Weighted mean of the squared distances from the point to the planes
+      double getError(const glm::vec3& point) const;
+    };
+
+    struct Edge
+    {
+      uint32_t u;
+      uint32_t v;
+      bool border;
+    };
+
+    struct Collapse
+    {
+      uint32_t from;
+      uint32_t to;
+      double cost;
+      double error;
+    };
+
+    // Weight of the planes keeping open borders in place, relative to the surface planes
+    static constexpr double BorderWeight = 10.0;
+
+    static std::vector<Edge> collectEdges(const std::vector<unsigned int>& indices, const std::vector<bool>& removed, const std::vector<uint32_t>& positionRoots);
+  };
+
+}
\ No newline at end of file
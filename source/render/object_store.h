@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "../math/types.h"
+#include "../math/model_matrix.h"
+#include "../scene/transform.h"
+#include "mesh.h"
+#include "material.h"
+
+namespace Lotus
+{
+
+  /*
+    Structure of arrays with the state of the objects of a renderer, indexed by their renderer handle.
+    Objects are queued the first time they are flagged in a frame, so updates only visit the changed ones
+  */
+  struct ObjectStore
+  {
+    enum DirtyFlag : uint8_t
+    {
+      TransformDirty = 1 << 0,
+      MeshDirty = 1 << 1,
+      MaterialDirty = 1 << 2,
+      ShaderDirty = 1 << 3
+    };
+
+    size_t size() const { return translations.size(); }
+
+    void resize(size_t size)
+    {
+      translations.resize(size, glm::vec3(0.0f));
+      rotations.resize(size, glm::fquat(1.0f, 0.0f, 0.0f, 0.0f));
+      scales.resize(size, glm::vec3(1.0f));
+      meshes.resize(size);
+      materials.resize(size);
+      dirtyFlags.resize(size, 0);
+    }
+
+    void initialize(uint32_t index, const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material)
+    {
+      if (index >= size())
+      {
+        resize(index + 1);
+      }
+
+      translations[index] = glm::vec3(0.0f);
+      rotations[index] = glm::fquat(1.0f, 0.0f, 0.0f, 0.0f);
+      scales[index] = glm::vec3(1.0f);
+      meshes[index] = mesh;
+      materials[index] = material;
+
+      clearDirty(index);
+    }
+
+    void release(uint32_t index)
+    {
+      meshes[index] = nullptr;
+      materials[index] = nullptr;
+
+      clearDirty(index);
+    }
+
+    // Moves the object at the place of another one, which must have been released
+    void move(uint32_t from, uint32_t to)
+    {
+      translations[to] = translations[from];
+      rotations[to] = rotations[from];
+      scales[to] = scales[from];
+      meshes[to] = std::move(meshes[from]);
+      materials[to] = std::move(materials[from]);
+
+      uint8_t flags = dirtyFlags[from];
+
+      dirtyFlags[from] = 0;
+      dirtyFlags[to] = 0;
+      markDirty(to, flags);
+    }
+
+    void markDirty(uint32_t index, uint8_t flags)
+    {
+      if (flags == 0)
+      {
+        return;
+      }
+
+      if (dirtyFlags[index] == 0)
+      {
+        dirtyQueue.push_back(index);
+      }
+
+      dirtyFlags[index] |= flags;
+    }
+
+    // Calls function(index, flags) once for every dirty object, leaving all of them clean
+    template <typename Function>
+    void consumeDirty(Function&& function)
+    {
+      for (uint32_t index : dirtyQueue)
+      {
+        // Released and moved objects leave their entries behind
+        if (index >= dirtyFlags.size() || dirtyFlags[index] == 0)
+        {
+          continue;
+        }
+
+        uint8_t flags = dirtyFlags[index];
+        dirtyFlags[index] = 0;
+
+        function(index, flags);
+      }
+
+      dirtyQueue.clear();
+    }
+
+    size_t getDirtyCount() const { return dirtyQueue.size(); }
+
+    glm::mat4 getModelMatrix(uint32_t index) const
+    {
+      return ModelMatrixKernel::compose(translations[index], rotations[index], scales[index]);
+    }
+
+    // Calls output(index, model) for every index in [indices, indices + count), see ModelMatrixKernel
+    template <typename Output>
+    void computeModelMatrices(const uint32_t* indices, size_t count, Output&& output) const
+    {
+      ModelMatrixKernel::compose(translations.data(), rotations.data(), scales.data(), indices, count, output);
+    }
+
+    std::vector<glm::vec3> translations;
+    std::vector<glm::fquat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    std::vector<std::shared_ptr<Material>> materials;
+    std::vector<uint8_t> dirtyFlags;
+
+  private:
+
+    void clearDirty(uint32_t index)
+    {
+      dirtyFlags[index] = 0;
+    }
+
+    std::vector<uint32_t> dirtyQueue;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace Lotus
+{
+  enum class RenderingMethod
+  {
+    Traditional,
+    Indirect
+  };
+}
\ No newline at end of file
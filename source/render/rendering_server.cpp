@@ -8,10 +8,11 @@
 namespace Lotus
 {
 
-  RenderingServer::RenderingServer() :
+  RenderingServer::RenderingServer(ThreadPool& engineThreadPool) :
     mode(RenderingMode::Fill),
     defaultObjectRenderingMethod(RenderingMethod::Indirect),
-    defaultTerrainRenderingMethod(RenderingMethod::Indirect)
+    defaultTerrainRenderingMethod(RenderingMethod::Indirect),
+    indirectObjectRenderer(engineThreadPool)
   {}
 
   void RenderingServer::startUp()
@@ -36,7 +37,7 @@ namespace Lotus
     lightsBuffer.bind();
 
     traditionalObjectRenderer.render();
-    indirectObjectRenderer.render();
+    indirectObjectRenderer.render(camera);
     terrainRenderer.render(camera);
 
     lightsBuffer.unbind();
@@ -100,12 +101,22 @@ namespace Lotus
     defaultObjectRenderingMethod = renderingMethod;
   }
 
-  std::shared_ptr<MeshObject> RenderingServer::createObject(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material)
+  void RenderingServer::setObjectFrustumCulling(bool enabled)
+  {
+    indirectObjectRenderer.setFrustumCullingEnabled(enabled);
+  }
+
+  void RenderingServer::setObjectVertexFormat(VertexFormat vertexFormat)
+  {
+    indirectObjectRenderer.setVertexFormat(vertexFormat);
+  }
+
+  std::shared_ptr<MeshObject> RenderingServer::createObject(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material)
   {
     return createObject(mesh, material, defaultObjectRenderingMethod);
   }
 
-  std::shared_ptr<MeshObject> RenderingServer::createObject(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material, RenderingMethod renderingMethod)
+  std::shared_ptr<MeshObject> RenderingServer::createObject(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material, RenderingMethod renderingMethod)
   {
     switch(renderingMethod)
     {
@@ -118,6 +129,23 @@ namespace Lotus
     }
   }
 
+  void RenderingServer::destroyObject(const std::shared_ptr<MeshObject>& object)
+  {
+    // Objects go back to the renderer that created them, whatever the default method is now
+    switch(object->getRenderingMethod())
+    {
+      case RenderingMethod::Traditional:
+        traditionalObjectRenderer.destroyObject(object);
+        break;
+      case RenderingMethod::Indirect:
+        indirectObjectRenderer.destroyObject(object);
+        break;
+      default:
+        indirectObjectRenderer.destroyObject(object);
+        break;
+    }
+  }
+
   std::shared_ptr<Material> RenderingServer::createMaterial(MaterialType type)
   {
     switch (type)
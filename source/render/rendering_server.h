@@ -10,6 +10,7 @@
 #include "gpu_structures.h"
 #include "gpu_buffer.h"
 #include "material.h"
+#include "rendering_method.h"
 #include "unlit_flat_material.h"
 #include "diffuse_flat_material.h"
 #include "diffuse_textured_material.h"
@@ -24,16 +25,10 @@ namespace Lotus
     Wireframe
   };
 
-  enum class RenderingMethod
-  {
-    Traditional,
-    Indirect
-  };
-
   class RenderingServer
   {
   public:
-    RenderingServer();
+    RenderingServer(ThreadPool& engineThreadPool);
 
     void startUp();
   
@@ -50,8 +45,11 @@ namespace Lotus
     
     /* Objects */
     void setDefaultObjectRenderingMethod(RenderingMethod renderingMethod);
-    std::shared_ptr<MeshObject> createObject(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material);
-    std::shared_ptr<MeshObject> createObject(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material, RenderingMethod renderingMethod);
+    void setObjectFrustumCulling(bool enabled);
+    void setObjectVertexFormat(VertexFormat vertexFormat);
+    std::shared_ptr<MeshObject> createObject(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material);
+    std::shared_ptr<MeshObject> createObject(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material, RenderingMethod renderingMethod);
+    void destroyObject(const std::shared_ptr<MeshObject>& object);
     std::shared_ptr<Material> createMaterial(MaterialType type);
 
     /* Terrain */
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace Lotus
+{
+
+  /*
+    Compact integer identifier assigned by the engine to every instance of T while it is alive.
+    Freed identifiers are reused, so renderers can keep per resource data in arrays indexed by it
+  */
+  template <typename T>
+  class ResourceID
+  {
+  public:
+
+    static constexpr uint32_t InvalidID = std::numeric_limits<uint32_t>::max();
+
+    ResourceID() : ID(acquire()) {}
+
+    // Copies are different resources, so they get their own identifier
+    ResourceID(const ResourceID& other) : ID(acquire()) {}
+
+    ~ResourceID()
+    {
+      release(ID);
+    }
+
+    ResourceID& operator=(const ResourceID& other) { return *this; }
+
+    uint32_t get() const { return ID; }
+
+  private:
+
+    struct Pool
+    {
+      std::mutex mutex;
+      std::vector<uint32_t> freeIDs;
+      uint32_t nextID = 0;
+    };
+
+    static Pool& getPool()
+    {
+      static Pool pool;
+      return pool;
+    }
+
+    static uint32_t acquire()
+    {
+      Pool& pool = getPool();
+      std::lock_guard<std::mutex> lock(pool.mutex);
+
+      if (!pool.freeIDs.empty())
+      {
+        uint32_t ID = pool.freeIDs.back();
+        pool.freeIDs.pop_back();
+        return ID;
+      }
+
+      return pool.nextID++;
+    }
+
+    static void release(uint32_t ID)
+    {
+      Pool& pool = getPool();
+      std::lock_guard<std::mutex> lock(pool.mutex);
+
+      pool.freeIDs.push_back(ID);
+    }
+
+    uint32_t ID;
+  };
+
+}
\ No newline at end of file
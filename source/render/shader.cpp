@@ -52,7 +52,7 @@ namespace Lotus
     Shader
   */
 
-  Shader::Shader(const std::filesystem::path& shaderPath, ShaderType shaderType) :
+  Shader::Shader(const std::filesystem::path& shaderPath, ShaderType shaderType, const std::vector<std::string>& defines) :
     path(shaderPath),
     type(shaderType)
   {
@@ -64,6 +64,7 @@ namespace Lotus
     // Read shader file to string
     code = readFileFromPath(path);
     code = preProcess(code, path, includeFileHistory);
+    code = addDefines(code, defines);
 
     compile();
   }
@@ -161,6 +162,39 @@ namespace Lotus
     return preProcessedCode;
   }
 
+  std::string Shader::addDefines(std::string fileCode, const std::vector<std::string>& defines)
+  {
+    if (defines.empty())
+    {
+      return fileCode;
+    }
+
+    std::string definesCode;
+
+    for (const std::string& define : defines)
+    {
+      definesCode += "#define " + define + "\n";
+    }
+
+    // Nothing but comments can come before the version directive
+    size_t versionPosition = fileCode.find("#version");
+    size_t insertPosition = versionPosition == std::string::npos ? 0 : fileCode.find('\n', versionPosition);
+
+    if (insertPosition == std::string::npos)
+    {
+      fileCode += "\n";
+      insertPosition = fileCode.size();
+    }
+    else if (versionPosition != std::string::npos)
+    {
+      insertPosition++;
+    }
+
+    fileCode.insert(insertPosition, definesCode);
+
+    return fileCode;
+  }
+
   void Shader::compile()
   {
     const char* shaderSource = code.c_str();
@@ -224,6 +258,14 @@ namespace Lotus
     linkRenderProgram(vertexShader, fragmentShader);
   }
 
+  ShaderProgram::ShaderProgram(const std::filesystem::path& vertexShaderPath, const std::filesystem::path& fragmentShaderPath, const std::vector<std::string>& defines) : programID(0)
+  {
+    Shader vertexShader(vertexShaderPath, ShaderType::Vertex, defines);
+    Shader fragmentShader(fragmentShaderPath, ShaderType::Fragment, defines);
+    
+    linkRenderProgram(vertexShader, fragmentShader);
+  }
+
   ShaderProgram::ShaderProgram(ShaderProgram&& program) noexcept
   {
     programID = program.programID;
@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <string>
 #include <set>
+#include <vector>
 #include "../math/types.h"
 
 namespace Lotus
@@ -18,7 +19,8 @@ namespace Lotus
   class Shader
   {
   public:
-    Shader(const std::filesystem::path& shaderPath, ShaderType shaderType);
+    // Each define is added as a preprocessor definition right after the version directive
+    Shader(const std::filesystem::path& shaderPath, ShaderType shaderType, const std::vector<std::string>& defines = {});
     ~Shader();
 
     uint32_t getID() const noexcept { return ID; };
@@ -27,6 +29,7 @@ namespace Lotus
   private:
     std::string readFileFromPath(const std::filesystem::path& filePath);
     std::string preProcess(std::string fileCode, const std::filesystem::path& filePath, std::set<std::filesystem::path>& fileHistory);
+    std::string addDefines(std::string fileCode, const std::vector<std::string>& defines);
     void compile();
 
     std::filesystem::path path;
@@ -51,6 +54,7 @@ namespace Lotus
     ShaderProgram(const Shader& vertexShader, const Shader& fragmentShader);
     ShaderProgram(const std::filesystem::path& computeShaderPath);
     ShaderProgram(const std::filesystem::path& vertexShaderPath, const std::filesystem::path& fragmentShaderPath);
+    ShaderProgram(const std::filesystem::path& vertexShaderPath, const std::filesystem::path& fragmentShaderPath, const std::vector<std::string>& defines);
     ShaderProgram() : programID(0) {}
     ShaderProgram(const ShaderProgram& program) = delete;
     ShaderProgram(ShaderProgram&& program) noexcept;
@@ -19,13 +19,17 @@ namespace Lotus
   {
     LOTUS_PROFILE_INCREASE_COUNTER(FrameCounter::AddedTraditionalObjects);
 
-    std::shared_ptr<MeshObject> object = std::make_shared<MeshObject>(mesh, material);
+    uint32_t handle = static_cast<uint32_t>(objects.size());
+
+    objectStore.initialize(handle, mesh, material);
+
+    std::shared_ptr<MeshObject> object = std::make_shared<MeshObject>(&objectStore, handle, RenderingMethod::Traditional);
     objects.push_back(object);
 
-    Handler<TraditionalRenderMesh> meshHandler = getMeshHandler(mesh);
+    Handler<TraditionalRenderMesh> meshHandler = acquireMeshHandler(mesh);
 
     TraditionalRenderObject renderObject;
-    renderObject.model = object->getModelMatrix();
+    renderObject.model = objectStore.getModelMatrix(handle);
     renderObject.mesh = meshHandler;
 
     renderObjects.push_back(renderObject);
@@ -33,6 +37,38 @@ namespace Lotus
     return object;
   }
 
+  void TraditionalObjectRenderer::destroyObject(const std::shared_ptr<MeshObject>& object)
+  {
+    uint32_t handle = object->rendererHandle;
+
+    if (handle >= objects.size() || objects[handle] != object)
+    {
+      LOTUS_LOG_WARN("[Traditional Renderer Warning] Tried to destroy object that does not belong to the renderer");
+      return;
+    }
+
+    releaseMeshHandler(renderObjects[handle].mesh);
+
+    objectStore.release(handle);
+    object->store = nullptr;
+
+    // The last object takes the place of the destroyed one, so the arrays stay packed
+    uint32_t lastHandle = static_cast<uint32_t>(objects.size() - 1);
+
+    if (handle != lastHandle)
+    {
+      objectStore.move(lastHandle, handle);
+    }
+
+    objects[handle] = objects.back();
+    renderObjects[handle] = renderObjects.back();
+    objects[handle]->rendererHandle = handle;
+
+    objects.pop_back();
+    renderObjects.pop_back();
+    objectStore.resize(objects.size());
+  }
+
   void TraditionalObjectRenderer::render()
   {
     updateObjects();
@@ -41,8 +77,7 @@ namespace Lotus
 
     for (int i = 0; i < objects.size(); i++)
     {
-      const std::shared_ptr<MeshObject>& meshObject = objects[i];
-      const std::shared_ptr<Material>& material = meshObject->getMaterial();
+      const std::shared_ptr<Material>& material = objectStore.materials[i];
       
       const TraditionalRenderObject& renderObject = renderObjects[i];
       const TraditionalRenderMesh& renderMesh = renderMeshes[renderObject.mesh.handle];
@@ -63,57 +98,86 @@ namespace Lotus
   {
     LOTUS_PROFILE_START_TIME(FrameTime::TraditionalObjectUpdateTime);
 
-    for (int i = 0; i < objects.size(); i++)
+    objectStore.consumeDirty([this](uint32_t i, uint8_t flags)
     {
-      const std::shared_ptr<MeshObject>& object = objects[i];
-      Transform* transform = &(object->transform);
-
       TraditionalRenderObject& renderObject = renderObjects[i];
 
-      if (transform->dirty)
+      if (flags & ObjectStore::TransformDirty)
       {
-        renderObject.model = object->getModelMatrix();
-        transform->dirty = false;
+        renderObject.model = objectStore.getModelMatrix(i);
       }
-      if (object->meshDirty)
+      if (flags & ObjectStore::MeshDirty)
       {
-        renderMeshes[renderObject.mesh.handle].references--;
-        renderObject.mesh = getMeshHandler(object->getMesh());
-        renderMeshes[renderObject.mesh.handle].references++;
-
-        object->meshDirty = false;
+        // Acquired first, so a mesh set again on the same object is not freed in between
+        Handler<TraditionalRenderMesh> previousMesh = renderObject.mesh;
+        renderObject.mesh = acquireMeshHandler(objectStore.meshes[i]);
+        releaseMeshHandler(previousMesh);
       }
-    }
+    });
 
     LOTUS_PROFILE_END_TIME(FrameTime::TraditionalObjectUpdateTime);
   }
 
-  Handler<TraditionalRenderMesh> TraditionalObjectRenderer::getMeshHandler(const std::shared_ptr<Mesh>& mesh)
+  Handler<TraditionalRenderMesh> TraditionalObjectRenderer::acquireMeshHandler(const std::shared_ptr<Mesh>& mesh)
   {
-    Handler<TraditionalRenderMesh> handler;
+    const uint32_t resourceID = mesh->getResourceID();
 
-    auto it = meshMap.find(mesh);
-
-    if (it == meshMap.end())
+    if (resourceID >= meshMap.size())
     {
-      const std::vector<MeshVertex>& vertices = mesh->getVertices();
-      const std::vector<unsigned int>& indices = mesh->getIndices();
+      meshMap.resize(resourceID + 1, { Handler<TraditionalRenderMesh>::InvalidHandle });
+    }
+
+    Handler<TraditionalRenderMesh> handler = meshMap[resourceID];
 
+    if (handler.handle == Handler<TraditionalRenderMesh>::InvalidHandle)
+    {
       TraditionalRenderMesh renderMesh;
-      renderMesh.references++;
       renderMesh.gpuMesh = new GPUMesh(*mesh);
+      renderMesh.aabb = mesh->getAABB();
+      renderMesh.boundingSphere = mesh->getBoundingSphere();
+
+      // Handlers of freed meshes are reused, so the handlers range stays compact
+      if (!freeMeshesHandlers.empty())
+      {
+        handler = freeMeshesHandlers.back();
+        freeMeshesHandlers.pop_back();
 
-      handler.handle = static_cast<uint32_t>(renderMeshes.size());
-      renderMeshes.push_back(renderMesh);
+        meshes[handler.handle] = mesh;
+        renderMeshes[handler.handle] = renderMesh;
+      }
+      else
+      {
+        handler.handle = static_cast<uint32_t>(renderMeshes.size());
+
+        meshes.push_back(mesh);
+        renderMeshes.push_back(renderMesh);
+      }
 
-      meshMap[mesh] = handler;
+      meshMap[resourceID] = handler;
     }
-    else
+
+    renderMeshes[handler.handle].references++;
+
+    return handler;
+  }
+
+  void TraditionalObjectRenderer::releaseMeshHandler(Handler<TraditionalRenderMesh> handler)
+  {
+    TraditionalRenderMesh& renderMesh = renderMeshes[handler.handle];
+
+    if (--renderMesh.references > 0)
     {
-      handler = (*it).second;
+      return;
     }
 
-    return handler;
+    delete renderMesh.gpuMesh;
+    renderMesh.gpuMesh = nullptr;
+
+    // Dropping the pointer lets MeshManager::cleanUnusedMeshes free the mesh, and its resource ID be reused
+    meshMap[meshes[handler.handle]->getResourceID()].handle = Handler<TraditionalRenderMesh>::InvalidHandle;
+    meshes[handler.handle] = nullptr;
+
+    freeMeshesHandlers.push_back(handler);
   }
 
 }
\ No newline at end of file
@@ -3,7 +3,6 @@
 #include <memory>
 #include <array>
 #include <vector>
-#include <unordered_map>
 #include "../../math/types.h"
 #include "../../scene/transform.h"
 #include "../../scene/camera.h"
@@ -12,6 +11,7 @@
 #include "../shader.h"
 #include "../material.h"
 #include "../mesh_object.h"
+#include "../object_store.h"
 #include "traditional_render_structures.h"
 
 namespace Lotus
@@ -24,26 +24,31 @@ namespace Lotus
     TraditionalObjectRenderer();
 
     std::shared_ptr<MeshObject> createObject(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material);
+    void destroyObject(const std::shared_ptr<MeshObject>& object);
   
     void render();
     void updateObjects();
 
   private:
 
-    Handler<TraditionalRenderMesh> getMeshHandler(const std::shared_ptr<Mesh>& mesh);
+    Handler<TraditionalRenderMesh> acquireMeshHandler(const std::shared_ptr<Mesh>& mesh);
+    void releaseMeshHandler(Handler<TraditionalRenderMesh> handler);
 
     /* Shaders */
     std::array<ShaderProgram, static_cast<unsigned int>(MaterialType::MaterialTypeCount ) * 2> shaders;
 
-    /* Maps */
-    std::unordered_map<std::shared_ptr<Mesh>, Handler<TraditionalRenderMesh>> meshMap;
+    /* Maps (indexed by resource ID) */
+    std::vector<Handler<TraditionalRenderMesh>> meshMap;
 
     /* Objects */
+    ObjectStore objectStore;
     std::vector<std::shared_ptr<MeshObject>> objects;
     std::vector<TraditionalRenderObject> renderObjects;
 
     /* Meshes */
+    std::vector<std::shared_ptr<Mesh>> meshes;
     std::vector<TraditionalRenderMesh> renderMeshes;
+    std::vector<Handler<TraditionalRenderMesh>> freeMeshesHandlers;
 
   };
 
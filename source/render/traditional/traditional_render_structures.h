@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../math/types.h"
+#include "../../math/bounds.h"
 #include "../gpu_mesh.h"
 
 namespace Lotus
@@ -10,6 +11,8 @@ namespace Lotus
   {
     GPUMesh* gpuMesh = nullptr;
     uint32_t references = 0;
+    AABB aabb;
+    BoundingSphere boundingSphere;
   };
 
   struct TraditionalRenderObject
@@ -23,7 +23,7 @@ namespace Lotus
       }
 
       unlitColor = color;
-      dirty = true;
+      markDirty();
     }
 
     virtual void setMaterialUniforms() override
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../math/types.h"
+#include "../math/bounds.h"
+#include "../math/quantization.h"
+#include "mesh.h"
+
+namespace Lotus
+{
+
+  // Vertex attributes read by a shader, combined as flags
+  enum VertexAttribute : uint32_t
+  {
+    PositionAttribute = 1 << 0,
+    NormalAttribute = 1 << 1,
+    UVAttribute = 1 << 2,
+    TangentAttribute = 1 << 3,  // Along with the bitangent
+    AllVertexAttributes = PositionAttribute | NormalAttribute | UVAttribute | TangentAttribute
+  };
+
+  enum class VertexFormat
+  {
+    Full,     // MeshVertex, 56 bytes
+    Compact   // CompactVertex, 20 bytes
+  };
+
+  /*
+    Quantized vertex. Positions are signed normalized values inside the mesh bounds, see VertexQuantization,
+    with the sign of the bitangent in the last component. Normals and tangents are octahedral encodings
+    stored as signed normalized values, the bitangent being derived from them, and UVs are half floats
+  */
+  struct CompactVertex
+  {
+    int16_t position[4];
+    int16_t normal[2];
+    uint16_t uv[2];
+    int16_t tangent[2];
+  };
+
+  /*
+    Mapping of the mesh bounds to the signed normalized range. The scale is the same for every axis, so the
+    dequantization can be folded in the model matrix without changing the direction of the transformed normals
+  */
+  struct VertexQuantization
+  {
+    glm::vec3 offset = glm::vec3(0.0f);
+    float scale = 1.0f;
+
+    static VertexQuantization fromBounds(const AABB& aabb)
+    {
+      VertexQuantization quantization;
+
+      if (!aabb.isValid())
+      {
+        return quantization;
+      }
+
+      const glm::vec3 extents = aabb.getExtents();
+
+      quantization.offset = aabb.getCenter();
+      quantization.scale = std::max(std::max(extents.x, extents.y), extents.z);
+
+      // Meshes collapsed to a point keep the unit scale
+      if (quantization.scale <= 0.0f)
+      {
+        quantization.scale = 1.0f;
+      }
+
+      return quantization;
+    }
+
+    CompactVertex compress(const MeshVertex& vertex) const
+    {
+      const glm::vec3 position = (vertex.position - offset) / scale;
+      const glm::vec2 normal = encodeOctahedral(vertex.normal);
+      const glm::vec2 tangent = encodeOctahedral(vertex.tangent);
+
+      // Mirrored UVs have a bitangent opposite to the cross product of the normal and the tangent
+      const bool mirrored = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.bitangent) < 0.0f;
+
+      CompactVertex compactVertex;
+      compactVertex.position[0] = quantizeSnorm16(position.x);
+      compactVertex.position[1] = quantizeSnorm16(position.y);
+      compactVertex.position[2] = quantizeSnorm16(position.z);
+      compactVertex.position[3] = mirrored ? -32767 : 32767;
+      compactVertex.normal[0] = quantizeSnorm16(normal.x);
+      compactVertex.normal[1] = quantizeSnorm16(normal.y);
+      compactVertex.uv[0] = quantizeHalf(vertex.uv.x);
+      compactVertex.uv[1] = quantizeHalf(vertex.uv.y);
+      compactVertex.tangent[0] = quantizeSnorm16(tangent.x);
+      compactVertex.tangent[1] = quantizeSnorm16(tangent.y);
+
+      return compactVertex;
+    }
+
+    // Same decoding as the vertex shaders, see shaders/common/vertex.glsl
+    MeshVertex decompress(const CompactVertex& compactVertex) const
+    {
+      MeshVertex vertex;
+      vertex.position = offset + scale * glm::vec3(
+          dequantizeSnorm16(compactVertex.position[0]),
+          dequantizeSnorm16(compactVertex.position[1]),
+          dequantizeSnorm16(compactVertex.position[2]));
+      vertex.normal = decodeOctahedral(glm::vec2(dequantizeSnorm16(compactVertex.normal[0]), dequantizeSnorm16(compactVertex.normal[1])));
+      vertex.uv = glm::vec2(dequantizeHalf(compactVertex.uv[0]), dequantizeHalf(compactVertex.uv[1]));
+      vertex.tangent = decodeOctahedral(glm::vec2(dequantizeSnorm16(compactVertex.tangent[0]), dequantizeSnorm16(compactVertex.tangent[1])));
+      vertex.bitangent = dequantizeSnorm16(compactVertex.position[3]) * glm::cross(vertex.normal, vertex.tangent);
+
+      return vertex;
+    }
+
+    // Model matrix that also dequantizes the positions, model * translate(offset) * scale(scale)
+    glm::mat4 getModelMatrix(const glm::mat4& model) const
+    {
+      glm::mat4 quantizedModel;
+      quantizedModel[0] = model[0] * scale;
+      quantizedModel[1] = model[1] * scale;
+      quantizedModel[2] = model[2] * scale;
+      quantizedModel[3] = model * glm::vec4(offset, 1.0f);
+
+      return quantizedModel;
+    }
+  };
+
+  // Preprocessor definitions that select the vertex inputs of shaders/common/vertex.glsl
+  inline std::vector<std::string> getVertexShaderDefines(VertexFormat format, uint32_t attributes)
+  {
+    std::vector<std::string> defines;
+
+    if (format == VertexFormat::Compact)
+    {
+      defines.push_back("COMPACT_VERTEX_FORMAT");
+    }
+
+    if (attributes & NormalAttribute)
+    {
+      defines.push_back("VERTEX_NORMAL");
+    }
+
+    if (attributes & UVAttribute)
+    {
+      defines.push_back("VERTEX_UV");
+    }
+
+    if (attributes & TangentAttribute)
+    {
+      defines.push_back("VERTEX_TANGENT");
+    }
+
+    return defines;
+  }
+
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../math/frustum.h"
 #include "node_3d.h"
 
 namespace Lotus
@@ -24,6 +25,16 @@ namespace Lotus
       return glm::perspective(glm::radians(fieldOfView), aspectRatio, zNearPlane, zFarPlane);
     }
 
+    glm::mat4 getViewProjectionMatrix() const
+    {
+      return getProjectionMatrix() * getViewMatrix();
+    }
+
+    Frustum getFrustum() const
+    {
+      return Frustum(getViewProjectionMatrix());
+    }
+
     float getFieldOfView() const { return fieldOfView;}
     float getZNearPlane() const { return zNearPlane;}
     float getZFarPlane() const { return zFarPlane;}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../math/types.h"
+#include "../math/model_matrix.h"
 
 namespace Lotus
 {
@@ -51,11 +52,7 @@ namespace Lotus
 
     glm::mat4 getModelMatrix() const
     {
-      const glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), localTranslation);
-      const glm::mat4 rotationMatrix = glm::toMat4(localRotation);
-      const glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), localScale);
-
-      return translationMatrix * rotationMatrix * scaleMatrix;
+      return ModelMatrixKernel::compose(localTranslation, localRotation, localScale);
     }
 
     glm::mat4 getViewMatrix() const
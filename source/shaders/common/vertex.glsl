@@ -0,0 +1,111 @@
+// Vertex inputs of the format used by the renderer, see VertexFormat and getVertexShaderDefines.
+// Only the attributes declared by the material are read, the position is always read
+
+#ifdef COMPACT_VERTEX_FORMAT
+
+// Signed normalized inside the mesh bounds, dequantized by the model matrix. The last component is the sign of the bitangent
+layout(location = 0) in vec4 vertexPosition;
+
+#ifdef VERTEX_NORMAL
+layout(location = 1) in vec2 vertexNormal;
+#endif
+
+#ifdef VERTEX_UV
+layout(location = 2) in vec2 vertexTexCoord;
+#endif
+
+#ifdef VERTEX_TANGENT
+layout(location = 3) in vec2 vertexTangent;
+#endif
+
+vec3 decodeOctahedral(vec2 encoded)
+{
+  vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+  // Points of the folded lower half are moved back towards their own quadrant
+  float fold = max(-direction.z, 0.0);
+  direction.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(direction.xy, vec2(0.0)));
+
+  return normalize(direction);
+}
+
+vec3 getVertexPosition()
+{
+  return vertexPosition.xyz;
+}
+
+#ifdef VERTEX_NORMAL
+vec3 getVertexNormal()
+{
+  return decodeOctahedral(vertexNormal);
+}
+#endif
+
+#ifdef VERTEX_UV
+vec2 getVertexTexCoord()
+{
+  return vertexTexCoord;
+}
+#endif
+
+#if defined(VERTEX_NORMAL) && defined(VERTEX_TANGENT)
+vec3 getVertexTangent()
+{
+  return decodeOctahedral(vertexTangent);
+}
+
+vec3 getVertexBitangent()
+{
+  return vertexPosition.w * cross(getVertexNormal(), getVertexTangent());
+}
+#endif
+
+#else
+
+layout(location = 0) in vec3 vertexPosition;
+
+#ifdef VERTEX_NORMAL
+layout(location = 1) in vec3 vertexNormal;
+#endif
+
+#ifdef VERTEX_UV
+layout(location = 2) in vec2 vertexTexCoord;
+#endif
+
+#ifdef VERTEX_TANGENT
+layout(location = 3) in vec3 vertexTangent;
+layout(location = 4) in vec3 vertexBitangent;
+#endif
+
+vec3 getVertexPosition()
+{
+  return vertexPosition;
+}
+
+#ifdef VERTEX_NORMAL
+vec3 getVertexNormal()
+{
+  return vertexNormal;
+}
+#endif
+
+#ifdef VERTEX_UV
+vec2 getVertexTexCoord()
+{
+  return vertexTexCoord;
+}
+#endif
+
+#ifdef VERTEX_TANGENT
+vec3 getVertexTangent()
+{
+  return vertexTangent;
+}
+
+vec3 getVertexBitangent()
+{
+  return vertexBitangent;
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #version 460 core
 
 #include ../common/primitives.glsl
+#include ../common/vertex.glsl
 
 layout(std140, binding = 0) readonly buffer Objects
 {
@@ -20,11 +21,6 @@ layout(std140, binding = 0) uniform CameraBuffer
   vec3 cameraPosition;
 };
 
-// Inputs
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec2 texCoord;
-
 // Outputs
 flat out uint fragObjectID;
 out vec3 fragPosition;
@@ -37,6 +33,10 @@ void main()
 
   Object object = objects[objectID];
 
+	vec3 position = getVertexPosition();
+	vec3 normal = getVertexNormal();
+	vec2 texCoord = getVertexTexCoord();
+
 	fragObjectID = objectID;
 	fragPosition = vec3(object.model * vec4(position, 1.0));
 	fragNormal = mat3(transpose(inverse(object.model))) * normal;
@@ -1,6 +1,7 @@
 #version 460 core
 
 #include ../common/primitives.glsl
+#include ../common/vertex.glsl
 
 // Shader storage buffer with the objects
 layout(std140, binding = 0) readonly buffer Objects
@@ -22,10 +23,6 @@ layout(std140, binding = 0) uniform CameraBuffer
   vec3 cameraPosition;
 };
 
-// Inputs
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 normal;
-
 // Outputs
 flat out uint fragObjectID;
 
@@ -35,6 +32,8 @@ void main()
 
   Object object = objects[objectID];
 
+	vec3 position = getVertexPosition();
+
 	fragObjectID = objectID;
 
 	gl_Position = projection * view * object.model * vec4(position, 1.0);
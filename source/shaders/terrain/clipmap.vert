@@ -27,7 +27,9 @@ layout(location = 0) uniform mat4 model;
 layout(location = 7) uniform float levelScale;
 layout(location = 8) uniform vec2 offset;
 
-layout(location = 9) uniform sampler2DArray heightmaps;
+layout(location = 9) uniform sampler2DArray heightmaps; // R32F or R16 unorm layers, both fetched as heights in [0, 1]
+
+const float heightScale = 64.0;
 
 /*
   Inputs
@@ -59,7 +61,7 @@ float height(ivec2 dataCoord)
   uint chunkY = (uint(dataCoord.y) / dataPerChunkSide + chunksOrigin.y) % chunksPerSide;
   uint layer = chunkY * chunksPerSide + chunkX;
 
-  return 64.0 * texelFetch(heightmaps, ivec3(texCoord, layer), 0).r;
+  return heightScale * texelFetch(heightmaps, ivec3(texCoord, layer), 0).r;
 }
 
 void main()
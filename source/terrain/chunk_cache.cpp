@@ -0,0 +1,376 @@
+#include "chunk_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "../util/log.h"
+#include "../math/quantization.h"
+
+#ifdef _WIN32
+  #define WIN32_LEAN_AND_MEAN
+  #define NOMINMAX
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace Lotus
+{
+  namespace
+  {
+    constexpr char ChunkFileMagic[4] = { 'L', 'C', 'H', 'K' };
+    
+    // Increase when the chunk file layout or the noise generation changes, so old files are ignored
+    constexpr uint32_t ChunkFileVersion = 1;
+
+    struct ChunkFileHeader
+    {
+      char magic[4];
+      uint32_t version;
+      uint32_t dataPerChunkSide;
+      uint32_t quantized;
+    };
+  }
+
+  /*
+    Read only view of a whole file mapped in memory
+  */
+  class MappedFile
+  {
+  public:
+
+    MappedFile(const std::filesystem::path& path) :
+      data(nullptr),
+      size(0)
+    {
+#ifdef _WIN32
+      file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      mapping = nullptr;
+
+      if (file == INVALID_HANDLE_VALUE)
+      {
+        return;
+      }
+
+      LARGE_INTEGER fileSize;
+
+      if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+      {
+        return;
+      }
+
+      mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+      if (mapping == nullptr)
+      {
+        return;
+      }
+
+      data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      size = data != nullptr ? static_cast<size_t>(fileSize.QuadPart) : 0;
+#else
+      file = open(path.c_str(), O_RDONLY);
+
+      if (file < 0)
+      {
+        return;
+      }
+
+      struct stat fileStatus;
+
+      if (fstat(file, &fileStatus) != 0 || fileStatus.st_size == 0)
+      {
+        return;
+      }
+
+      void* mapped = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+      if (mapped == MAP_FAILED)
+      {
+        return;
+      }
+
+      data = static_cast<const uint8_t*>(mapped);
+      size = fileStatus.st_size;
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+      if (data != nullptr)
+      {
+        UnmapViewOfFile(data);
+      }
+      if (mapping != nullptr)
+      {
+        CloseHandle(mapping);
+      }
+      if (file != INVALID_HANDLE_VALUE)
+      {
+        CloseHandle(file);
+      }
+#else
+      if (data != nullptr)
+      {
+        munmap(const_cast<uint8_t*>(data), size);
+      }
+      if (file >= 0)
+      {
+        close(file);
+      }
+#endif
+    }
+
+    MappedFile(const MappedFile& mappedFile) = delete;
+
+    MappedFile& operator=(const MappedFile& other) = delete;
+
+    const uint8_t* getData() const { return data; }
+    size_t getSize() const { return size; }
+
+  private:
+    const uint8_t* data;
+    size_t size;
+
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int file;
+#endif
+  };
+
+  ChunkCache::ChunkCache(
+      const std::filesystem::path& cacheDirectory,
+      const PerlinNoiseConfig& noiseConfig,
+      uint16_t cacheDataPerChunkSide,
+      bool cacheQuantized) :
+    dataPerChunkSide(cacheDataPerChunkSide),
+    quantized(cacheQuantized)
+  {
+    std::stringstream configName;
+    configName << std::hex << hashConfig(noiseConfig, dataPerChunkSide, quantized);
+
+    directory = cacheDirectory / configName.str();
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    if (error)
+    {
+      LOTUS_LOG_WARN("[Chunk Cache Warning] Could not create cache directory {0}", directory.string());
+    }
+  }
+
+  bool ChunkCache::load(const glm::ivec2& offset, float* destination) const
+  {
+    const uint8_t* payload;
+    MappedFile file(getChunkPath(offset));
+
+    if (!validate(file, payload))
+    {
+      return false;
+    }
+
+    const size_t dataAmount = static_cast<size_t>(dataPerChunkSide) * dataPerChunkSide;
+
+    if (quantized)
+    {
+      for (size_t i = 0; i < dataAmount; i++)
+      {
+        uint16_t value;
+        std::memcpy(&value, payload + i * sizeof(uint16_t), sizeof(uint16_t));
+        destination[i] = dequantizeUnorm16(value);
+      }
+    }
+    else
+    {
+      std::memcpy(destination, payload, dataAmount * sizeof(float));
+    }
+
+    return true;
+  }
+
+  bool ChunkCache::load(const glm::ivec2& offset, uint16_t* destination) const
+  {
+    const uint8_t* payload;
+    MappedFile file(getChunkPath(offset));
+
+    if (!validate(file, payload))
+    {
+      return false;
+    }
+
+    const size_t dataAmount = static_cast<size_t>(dataPerChunkSide) * dataPerChunkSide;
+
+    if (quantized)
+    {
+      std::memcpy(destination, payload, dataAmount * sizeof(uint16_t));
+    }
+    else
+    {
+      for (size_t i = 0; i < dataAmount; i++)
+      {
+        float value;
+        std::memcpy(&value, payload + i * sizeof(float), sizeof(float));
+        destination[i] = quantizeUnorm16(value);
+      }
+    }
+
+    return true;
+  }
+
+  void ChunkCache::store(const glm::ivec2& offset, const float* source) const
+  {
+    const size_t dataAmount = static_cast<size_t>(dataPerChunkSide) * dataPerChunkSide;
+
+    if (quantized)
+    {
+      std::vector<uint16_t> quantizedData(dataAmount);
+
+      for (size_t i = 0; i < dataAmount; i++)
+      {
+        quantizedData[i] = quantizeUnorm16(source[i]);
+      }
+
+      write(offset, quantizedData.data());
+    }
+    else
+    {
+      write(offset, source);
+    }
+  }
+
+  void ChunkCache::store(const glm::ivec2& offset, const uint16_t* source) const
+  {
+    const size_t dataAmount = static_cast<size_t>(dataPerChunkSide) * dataPerChunkSide;
+
+    if (quantized)
+    {
+      write(offset, source);
+    }
+    else
+    {
+      std::vector<float> floatData(dataAmount);
+
+      for (size_t i = 0; i < dataAmount; i++)
+      {
+        floatData[i] = dequantizeUnorm16(source[i]);
+      }
+
+      write(offset, floatData.data());
+    }
+  }
+
+  size_t ChunkCache::getPayloadSize() const
+  {
+    return static_cast<size_t>(dataPerChunkSide) * dataPerChunkSide * (quantized ? sizeof(uint16_t) : sizeof(float));
+  }
+
+  bool ChunkCache::validate(const MappedFile& file, const uint8_t*& payload) const
+  {
+    if (file.getData() == nullptr || file.getSize() != sizeof(ChunkFileHeader) + getPayloadSize())
+    {
+      return false;
+    }
+
+    ChunkFileHeader header;
+    std::memcpy(&header, file.getData(), sizeof(ChunkFileHeader));
+
+    if (std::memcmp(header.magic, ChunkFileMagic, sizeof(ChunkFileMagic)) != 0 ||
+        header.version != ChunkFileVersion ||
+        header.dataPerChunkSide != dataPerChunkSide ||
+        header.quantized != static_cast<uint32_t>(quantized))
+    {
+      return false;
+    }
+
+    payload = file.getData() + sizeof(ChunkFileHeader);
+
+    return true;
+  }
+
+  void ChunkCache::write(const glm::ivec2& offset, const void* payload) const
+  {
+    ChunkFileHeader header;
+    std::memcpy(header.magic, ChunkFileMagic, sizeof(ChunkFileMagic));
+    header.version = ChunkFileVersion;
+    header.dataPerChunkSide = dataPerChunkSide;
+    header.quantized = quantized;
+
+    std::filesystem::path path = getChunkPath(offset);
+
+    // Chunks are written under a name unique to the thread and then renamed, so a concurrent
+    // load never maps a partially written file
+    std::stringstream temporaryName;
+    temporaryName << path.filename().string() << "." << std::this_thread::get_id() << ".tmp";
+
+    std::filesystem::path temporaryPath = path.parent_path() / temporaryName.str();
+
+    {
+      std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+      if (!file.is_open())
+      {
+        LOTUS_LOG_WARN("[Chunk Cache Warning] Could not write chunk file {0}", temporaryPath.string());
+        return;
+      }
+
+      file.write(reinterpret_cast<const char*>(&header), sizeof(ChunkFileHeader));
+      file.write(static_cast<const char*>(payload), getPayloadSize());
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+
+    if (error)
+    {
+      std::filesystem::remove(temporaryPath, error);
+    }
+  }
+
+  std::filesystem::path ChunkCache::getChunkPath(const glm::ivec2& offset) const
+  {
+    return directory / (std::to_string(offset.x) + "_" + std::to_string(offset.y) + ".chunk");
+  }
+
+  uint64_t ChunkCache::hashConfig(const PerlinNoiseConfig& noiseConfig, uint16_t dataPerChunkSide, bool quantized)
+  {
+    // FNV-1a over every field that changes the generated data, the offset is part of the file name instead
+    uint64_t hash = 14695981039346656037ull;
+
+    auto combine = [&hash](const void* value, size_t size)
+    {
+      const uint8_t* bytes = static_cast<const uint8_t*>(value);
+
+      for (size_t i = 0; i < size; i++)
+      {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+      }
+    };
+
+    // Clamped like Perlin2DArray::fill, so configurations generating the same data share their files
+    double frequency = std::clamp(noiseConfig.frequency, 0.1, 64.0);
+    int32_t octaves = std::clamp(noiseConfig.octaves, 1, 16);
+    uint32_t version = ChunkFileVersion;
+    uint8_t quantizedByte = quantized;
+
+    combine(&noiseConfig.seed, sizeof(noiseConfig.seed));
+    combine(&frequency, sizeof(frequency));
+    combine(&octaves, sizeof(octaves));
+    combine(&dataPerChunkSide, sizeof(dataPerChunkSide));
+    combine(&quantizedByte, sizeof(quantizedByte));
+    combine(&version, sizeof(version));
+
+    return hash;
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <filesystem>
+#include "../math/types.h"
+#include "../math/noise.h"
+
+namespace Lotus
+{
+  class MappedFile;
+
+  /*
+    Disk storage for generated chunks. Files are grouped in a folder per noise configuration
+    and named after the chunk offset, so any chunk generated with the same configuration can
+    be read back instead of evaluating the noise again
+  */
+  class ChunkCache
+  {
+  public:
+
+    ChunkCache(
+        const std::filesystem::path& cacheDirectory,
+        const PerlinNoiseConfig& noiseConfig,
+        uint16_t dataPerChunkSide,
+        bool quantized = false);
+
+    bool load(const glm::ivec2& offset, float* destination) const;
+    bool load(const glm::ivec2& offset, uint16_t* destination) const;
+    void store(const glm::ivec2& offset, const float* source) const;
+    void store(const glm::ivec2& offset, const uint16_t* source) const;
+
+    const std::filesystem::path& getDirectory() const { return directory; }
+    bool isQuantized() const { return quantized; }
+
+  private:
+
+    std::filesystem::path getChunkPath(const glm::ivec2& offset) const;
+    size_t getPayloadSize() const;
+
+    bool validate(const MappedFile& file, const uint8_t*& payload) const;
+    void write(const glm::ivec2& offset, const void* payload) const;
+
+    static uint64_t hashConfig(const PerlinNoiseConfig& noiseConfig, uint16_t dataPerChunkSide, bool quantized);
+
+    std::filesystem::path directory;
+    uint16_t dataPerChunkSide;
+    bool quantized;
+  };
+
+}
\ No newline at end of file
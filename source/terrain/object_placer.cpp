@@ -18,6 +18,8 @@ namespace Lotus
     samplesBeforeRejection(placerSamplesBeforeRejection),
     randomizer(seed),
     dataGenerator(placerDataGenerator),
+    chunksObjects(placerDataGenerator->getChunksAmount()),
+    objectsCount(0),
     renderingServer(placerRenderingServer),
     renderingMethod(placerRenderingMethod)
   {
@@ -110,14 +112,24 @@ namespace Lotus
 
     LOTUS_LOG_INFO("[Object Placer Log] Generating objects on chunk ({0}, {1})", offset.x / dataGenerator->getDataPerChunkSide(), offset.y / dataGenerator->getDataPerChunkSide());
 
-    const float* heightData = dataGenerator->getChunkData(x ,y);
+    std::vector<PlacedObject>& chunkObjects = chunksObjects[y * dataGenerator->getChunksPerSide() + x];
+
+    // Objects of the chunk that previously occupied this slot are recycled before creating new ones
+    std::vector<std::vector<std::shared_ptr<MeshObject>>> recycledObjects(objectItemsPool.size());
+
+    for (PlacedObject& placedObject : chunkObjects)
+    {
+      recycledObjects[placedObject.itemIndex].push_back(std::move(placedObject.object));
+    }
+
+    chunkObjects.clear();
 
     std::vector<glm::vec2> points = PoissonDiscSampler::samplePoints(radius, dataGenerator->getDataPerChunkSide(), dataGenerator->getDataPerChunkSide(), samplesBeforeRejection);
   
     for (const glm::vec2& point : points)
     {
       glm::ivec2 dataPoint(point.x, point.y);
-      glm::vec3 translation = { point.x, heightData[dataPoint.y * dataGenerator->getDataPerChunkSide() + dataPoint.x] , point.y };
+      glm::vec3 translation = { point.x, dataGenerator->getChunkValue(x, y, dataPoint.y * dataGenerator->getDataPerChunkSide() + dataPoint.x), point.y };
       translation.y *= 64;
 
       translation += worldOffset;
@@ -126,15 +138,64 @@ namespace Lotus
 
       const ObjectPlacerItem& objectItem = objectItemsPool[objectIndex];
 
-      std::shared_ptr<MeshObject> object = renderingServer->createObject(objectItem.mesh, objectItem.material, renderingMethod);
+      std::shared_ptr<MeshObject> object = acquireObject(objectIndex, recycledObjects);
       object->setTranslation(translation);
+      object->setScale(glm::vec3(1.0f));
 
       if (objectItem.randomScale)
       {
         float scale = randomizer.getFloatRange(0.7, 1.1);
         object->scale(scale);
       }
+
+      chunkObjects.push_back({ object, static_cast<uint32_t>(objectIndex) });
+    }
+
+    for (const std::vector<std::shared_ptr<MeshObject>>& itemObjects : recycledObjects)
+    {
+      for (const std::shared_ptr<MeshObject>& object : itemObjects)
+      {
+        renderingServer->destroyObject(object);
+        objectsCount--;
+      }
+    }
+  }
+
+  std::shared_ptr<MeshObject> ObjectPlacer::acquireObject(uint32_t itemIndex, std::vector<std::vector<std::shared_ptr<MeshObject>>>& recycledObjects)
+  {
+    const ObjectPlacerItem& objectItem = objectItemsPool[itemIndex];
+
+    // An object of the same item can be repositioned without being rebatched by the renderer
+    if (!recycledObjects[itemIndex].empty())
+    {
+      std::shared_ptr<MeshObject> object = std::move(recycledObjects[itemIndex].back());
+      recycledObjects[itemIndex].pop_back();
+      return object;
+    }
+
+    for (std::vector<std::shared_ptr<MeshObject>>& itemObjects : recycledObjects)
+    {
+      if (!itemObjects.empty())
+      {
+        std::shared_ptr<MeshObject> object = std::move(itemObjects.back());
+        itemObjects.pop_back();
+
+        if (object->getMesh() != objectItem.mesh)
+        {
+          object->setMesh(objectItem.mesh);
+        }
+        if (object->getMaterial() != objectItem.material)
+        {
+          object->setMaterial(objectItem.material);
+        }
+
+        return object;
+      }
     }
+
+    objectsCount++;
+
+    return renderingServer->createObject(objectItem.mesh, objectItem.material, renderingMethod);
   }
 
 }
\ No newline at end of file
@@ -28,6 +28,8 @@ namespace Lotus
 
     void update(bool forced = false);
 
+    uint32_t getObjectsCount() const { return objectsCount; }
+
   private:
     
     struct ObjectPlacerItem
@@ -37,9 +39,17 @@ namespace Lotus
       bool randomScale;
     };
 
+    struct PlacedObject
+    {
+      std::shared_ptr<MeshObject> object;
+      uint32_t itemIndex;
+    };
+
     void generateObjects(const glm::ivec2& chunk);
     void generateObjects(int x, int y);
 
+    std::shared_ptr<MeshObject> acquireObject(uint32_t itemIndex, std::vector<std::vector<std::shared_ptr<MeshObject>>>& recycledObjects);
+
     float radius;
     uint8_t samplesBeforeRejection;
     Randomizer randomizer;
@@ -47,6 +57,10 @@ namespace Lotus
 
     std::vector<ObjectPlacerItem> objectItemsPool;
 
+    // Objects owned by each chunk slot of the data generator, indexed as y * chunksPerSide + x
+    std::vector<std::vector<PlacedObject>> chunksObjects;
+    uint32_t objectsCount;
+
     RenderingServer* renderingServer;
     RenderingMethod renderingMethod;
 
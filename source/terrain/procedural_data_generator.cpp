@@ -1,7 +1,10 @@
 #include "procedural_data_generator.h"
 
 #include <cmath>
+#include <algorithm>
 #include "../util/log.h"
+#include "../util/profile.h"
+#include "../math/quantization.h"
 
 namespace Lotus
 {
@@ -13,20 +16,25 @@ namespace Lotus
   constexpr char ReloadedFlag     = 0b10000;
 
   ProceduralDataGenerator::ProceduralDataGenerator(
+      ThreadPool& engineThreadPool,
       uint16_t generatorDataPerChunkSide,
       uint8_t generatorChunksPerSide,
       const PerlinNoiseConfig& generatorNoiseConfig,
+      ProceduralDataFormat generatorDataFormat,
       const glm::vec2& initialObserverPosition) : 
     dataPerChunkSide(generatorDataPerChunkSide),
     chunksPerSide(generatorChunksPerSide),
-    noiseConfig(generatorNoiseConfig)
+    noiseConfig(generatorNoiseConfig),
+    dataFormat(generatorDataFormat),
+    asynchronousLoading(false),
+    previousObserverPosition(initialObserverPosition),
+    threadPool(engineThreadPool)
   {
     chunksData.reserve(chunksPerSide * chunksPerSide);
 
     for (int i = 0; i < chunksPerSide * chunksPerSide; i++)
     {
-      float* chunkData = new float[dataPerChunkSide * dataPerChunkSide];
-      chunksData.push_back(chunkData);
+      chunksData.push_back(allocateChunkData());
     }
 
     reload(initialObserverPosition);
@@ -34,22 +42,44 @@ namespace Lotus
 
   ProceduralDataGenerator::~ProceduralDataGenerator()
   {
+    waitPrefetch(horizontalPrefetch);
+    waitPrefetch(verticalPrefetch);
+    releasePrefetch(horizontalPrefetch);
+    releasePrefetch(verticalPrefetch);
+
     for (uint16_t i = 0; i < chunksPerSide * chunksPerSide; i++)
     {
       delete[] chunksData[i];
     }
+
+    for (uint8_t* chunkData : spareChunksData)
+    {
+      delete[] chunkData;
+    }
   }
 
-  const float* ProceduralDataGenerator::getChunkData(const glm::uvec2& chunk) const
+  const void* ProceduralDataGenerator::getChunkData(const glm::uvec2& chunk) const
   {
     return getChunkData(chunk.x, chunk.y);
   }
 
-  const float* ProceduralDataGenerator::getChunkData(uint8_t x, uint8_t y) const
+  const void* ProceduralDataGenerator::getChunkData(uint8_t x, uint8_t y) const
   {
     return chunksData[y * chunksPerSide + x];
   }
 
+  float ProceduralDataGenerator::getChunkValue(uint8_t x, uint8_t y, uint32_t dataIndex) const
+  {
+    const uint8_t* chunkData = chunksData[y * chunksPerSide + x];
+
+    if (dataFormat == ProceduralDataFormat::RUnsigned16)
+    {
+      return dequantizeUnorm16(reinterpret_cast<const uint16_t*>(chunkData)[dataIndex]);
+    }
+
+    return reinterpret_cast<const float*>(chunkData)[dataIndex];
+  }
+
   bool ProceduralDataGenerator::updatedSincePreviousFrame(ProceduralUpdateRegion region) const
   {
     switch (region)
@@ -69,6 +99,23 @@ namespace Lotus
     }
   }
 
+  void ProceduralDataGenerator::enableChunkCache(const std::filesystem::path& directory, bool quantized)
+  {
+    // Prefetches read the cache from the worker threads
+    waitPrefetch(horizontalPrefetch);
+    waitPrefetch(verticalPrefetch);
+
+    chunkCache = std::make_unique<ChunkCache>(directory, noiseConfig, dataPerChunkSide, quantized);
+  }
+
+  void ProceduralDataGenerator::disableChunkCache()
+  {
+    waitPrefetch(horizontalPrefetch);
+    waitPrefetch(verticalPrefetch);
+
+    chunkCache.reset();
+  }
+
   void ProceduralDataGenerator::registerObserverPosition(const glm::vec2& observerPosition)
   {
     glm::vec2 difference;
@@ -76,31 +123,222 @@ namespace Lotus
     difference.x = observerPosition.x - dataOrigin.x;
     difference.y = observerPosition.y - dataOrigin.y;
 
+    glm::vec2 motion = observerPosition - previousObserverPosition;
+    previousObserverPosition = observerPosition;
+
     stateSincePreviousFrame = UnchangedFlag;
 
+    LOTUS_PROFILE_START_TIME(FrameTime::DataGenerationTime);
+
     if (std::fabsf(difference.x) > 2 * dataPerChunkSide || std::fabsf(difference.y) > 2 * dataPerChunkSide)
     {
       reload(observerPosition);
+      LOTUS_PROFILE_END_TIME(FrameTime::DataGenerationTime);
       return;
     }
 
-    if (difference.x > dataPerChunkSide)
+    if (asynchronousLoading)
     {
-      loadRightChunks();
+      streamChunks(horizontalPrefetch, difference.x, motion.x, ProceduralUpdateRegion::RightChunks, ProceduralUpdateRegion::LeftChunks);
+      streamChunks(verticalPrefetch, difference.y, motion.y, ProceduralUpdateRegion::BottomChunks, ProceduralUpdateRegion::TopChunks);
     }
-    else if(difference.x < -dataPerChunkSide)
+    else
     {
-      loadLeftChunks();
-    } 
+      if (difference.x > dataPerChunkSide)
+      {
+        loadRightChunks();
+      }
+      else if(difference.x < -dataPerChunkSide)
+      {
+        loadLeftChunks();
+      } 
     
-    if (difference.y > dataPerChunkSide)
+      if (difference.y > dataPerChunkSide)
+      {
+        loadBottomChunks();
+      }
+      else if (difference.y < -dataPerChunkSide)
+      {
+        loadTopChunks();
+      }
+    }
+
+    LOTUS_PROFILE_END_TIME(FrameTime::DataGenerationTime);
+  }
+
+  void ProceduralDataGenerator::streamChunks(
+      ChunksPrefetch& prefetch,
+      float difference,
+      float motion,
+      ProceduralUpdateRegion positiveRegion,
+      ProceduralUpdateRegion negativeRegion)
+  {
+    bool crossed = std::fabs(difference) > dataPerChunkSide;
+
+    ProceduralUpdateRegion region;
+
+    if (crossed)
+    {
+      region = difference > 0 ? positiveRegion : negativeRegion;
+    }
+    else if (motion != 0)
+    {
+      region = motion > 0 ? positiveRegion : negativeRegion;
+    }
+    else
+    {
+      return;
+    }
+
+    requestPrefetch(prefetch, region);
+
+    // Until the prefetch completes the observer keeps seeing the current chunks, the crossing is
+    // retried on the next frames instead of blocking on the generation
+    if (crossed && prefetch.isReady())
+    {
+      loadChunks(region);
+    }
+  }
+
+  void ProceduralDataGenerator::requestPrefetch(ChunksPrefetch& prefetch, ProceduralUpdateRegion region)
+  {
+    glm::ivec2 origin = dataOrigin;
+    glm::ivec2 firstDataChunk(0, 0);
+    glm::ivec2 dataChunkStep(0, 0);
+
+    switch (region)
+    {
+      case ProceduralUpdateRegion::TopChunks:
+        origin.y -= dataPerChunkSide;
+        dataChunkStep.x = 1;
+        break;
+      case ProceduralUpdateRegion::RightChunks:
+        origin.x += dataPerChunkSide;
+        firstDataChunk.x = chunksPerSide - 1;
+        dataChunkStep.y = 1;
+        break;
+      case ProceduralUpdateRegion::BottomChunks:
+        origin.y += dataPerChunkSide;
+        firstDataChunk.y = chunksPerSide - 1;
+        dataChunkStep.x = 1;
+        break;
+      case ProceduralUpdateRegion::LeftChunks:
+        origin.x -= dataPerChunkSide;
+        dataChunkStep.y = 1;
+        break;
+      default:
+        return;
+    }
+
+    std::vector<glm::ivec2> offsets;
+    offsets.reserve(chunksPerSide);
+
+    for (int i = 0; i < chunksPerSide; i++)
+    {
+      offsets.push_back(getDataChunkOffset(origin, firstDataChunk + dataChunkStep * i));
+    }
+
+    if (prefetch.active)
+    {
+      if (prefetch.region == region && prefetch.offsets == offsets)
+      {
+        return;
+      }
+
+      // Buffers of a prefetch still being generated can't be reused yet
+      if (!prefetch.isReady())
+      {
+        return;
+      }
+
+      releasePrefetch(prefetch);
+    }
+
+    prefetch.region = region;
+    prefetch.offsets = offsets;
+    prefetch.chunksData.clear();
+
+    for (int i = 0; i < chunksPerSide; i++)
+    {
+      if (spareChunksData.empty())
+      {
+        spareChunksData.push_back(allocateChunkData());
+      }
+
+      prefetch.chunksData.push_back(spareChunksData.back());
+      spareChunksData.pop_back();
+    }
+
+    prefetch.remaining = chunksPerSide;
+    prefetch.active = true;
+
+    for (int i = 0; i < chunksPerSide; i++)
+    {
+      glm::ivec2 offset = offsets[i];
+      uint8_t* chunkData = prefetch.chunksData[i];
+      std::atomic<uint32_t>* remaining = &prefetch.remaining;
+
+      threadPool.submit([this, offset, chunkData, remaining]()
+      {
+        generateChunkData(offset, chunkData);
+
+        if (--(*remaining) == 0)
+        {
+          remaining->notify_all();
+        }
+      });
+    }
+  }
+
+  void ProceduralDataGenerator::releasePrefetch(ChunksPrefetch& prefetch)
+  {
+    LOTUS_ASSERT(prefetch.remaining == 0, "[Procedural Data Generator Error] Tried to release a prefetch that is still being generated");
+
+    for (uint8_t* chunkData : prefetch.chunksData)
+    {
+      if (chunkData != nullptr)
+      {
+        spareChunksData.push_back(chunkData);
+      }
+    }
+
+    prefetch.offsets.clear();
+    prefetch.chunksData.clear();
+    prefetch.active = false;
+  }
+
+  void ProceduralDataGenerator::waitPrefetch(ChunksPrefetch& prefetch)
+  {
+    uint32_t remaining;
+
+    while ((remaining = prefetch.remaining.load()) != 0)
     {
-      loadBottomChunks();
+      prefetch.remaining.wait(remaining);
     }
-    else if (difference.y < -dataPerChunkSide)
+  }
+
+  bool ProceduralDataGenerator::takePrefetchedData(const glm::ivec2& offset, uint8_t*& chunkData)
+  {
+    for (ChunksPrefetch* prefetch : { &horizontalPrefetch, &verticalPrefetch })
     {
-      loadTopChunks();
+      if (!prefetch->isReady())
+      {
+        continue;
+      }
+
+      for (size_t i = 0; i < prefetch->offsets.size(); i++)
+      {
+        if (prefetch->offsets[i] == offset && prefetch->chunksData[i] != nullptr)
+        {
+          spareChunksData.push_back(chunkData);
+          chunkData = prefetch->chunksData[i];
+          prefetch->chunksData[i] = nullptr;
+          return true;
+        }
+      }
     }
+
+    return false;
   }
 
   void ProceduralDataGenerator::reload(const glm::vec2& position)
@@ -111,28 +349,58 @@ namespace Lotus
     chunksOrigin.x = 0;
     chunksOrigin.y = 0;
 
+    std::vector<glm::uvec2> chunks;
+    chunks.reserve(getChunksAmount());
+
     for (uint8_t x = 0; x < chunksPerSide; x++)
     {
       for (uint8_t y = 0; y < chunksPerSide; y++)
       {
-        loadChunkData(x, y);
+        chunks.emplace_back(x, y);
       }
     }
 
+    loadChunksData(chunks);
+
     stateSincePreviousFrame = ReloadedFlag;
     LOTUS_LOG_INFO("[Procedural Data Generator Log] All chunks reloaded");
   }
 
+  void ProceduralDataGenerator::loadChunks(ProceduralUpdateRegion region)
+  {
+    switch (region)
+    {
+      case ProceduralUpdateRegion::TopChunks:
+        loadTopChunks();
+        break;
+      case ProceduralUpdateRegion::RightChunks:
+        loadRightChunks();
+        break;
+      case ProceduralUpdateRegion::BottomChunks:
+        loadBottomChunks();
+        break;
+      case ProceduralUpdateRegion::LeftChunks:
+        loadLeftChunks();
+        break;
+      default:
+        break;
+    }
+  }
+
   void ProceduralDataGenerator::loadTopChunks()
   {
     dataOrigin.y -= dataPerChunkSide;
     chunksOrigin.y = (chunksOrigin.y + chunksPerSide - 1) % chunksPerSide;
     
+    std::vector<glm::uvec2> chunks;
+
     for (int x = 0; x < chunksPerSide; x++)
     {
-      loadChunkData(x, getChunksTop());
+      chunks.emplace_back(x, getChunksTop());
     }
 
+    loadChunksData(chunks);
+
     stateSincePreviousFrame |= LoadedTopFlag;
     LOTUS_LOG_INFO("[Procedural Data Generator Log] Loaded top chunks");
   }
@@ -142,11 +410,15 @@ namespace Lotus
     dataOrigin.x += dataPerChunkSide;
     chunksOrigin.x = (chunksOrigin.x + 1) % chunksPerSide;
 
+    std::vector<glm::uvec2> chunks;
+
     for (int y = 0; y < chunksPerSide; y++)
     {
-      loadChunkData(getChunksRight(), y);
+      chunks.emplace_back(getChunksRight(), y);
     }
 
+    loadChunksData(chunks);
+
     stateSincePreviousFrame |= LoadedRightFlag;
     LOTUS_LOG_INFO("[Procedural Data Generator Log] Loaded right chunks");
   }
@@ -156,11 +428,15 @@ namespace Lotus
     dataOrigin.y += dataPerChunkSide;
     chunksOrigin.y = (chunksOrigin.y + 1) % chunksPerSide;
 
+    std::vector<glm::uvec2> chunks;
+
     for (int x = 0; x < chunksPerSide; x++)
     {
-      loadChunkData(x, getChunksBottom());
+      chunks.emplace_back(x, getChunksBottom());
     }
 
+    loadChunksData(chunks);
+
     stateSincePreviousFrame |= LoadedBottomFlag;
     LOTUS_LOG_INFO("[Procedural Data Generator Log] Loaded bottom chunks");
   }
@@ -170,15 +446,62 @@ namespace Lotus
     dataOrigin.x -= dataPerChunkSide;
     chunksOrigin.x = (chunksOrigin.x + chunksPerSide - 1) % chunksPerSide;
     
+    std::vector<glm::uvec2> chunks;
+
     for (int y = 0; y < chunksPerSide; y++)
     {
-      loadChunkData(getChunksLeft(), y);
+      chunks.emplace_back(getChunksLeft(), y);
     }
 
+    loadChunksData(chunks);
+
     stateSincePreviousFrame |= LoadedLeftFlag;
     LOTUS_LOG_INFO("[Procedural Data Generator Log] Loaded left chunks");
   }
 
+  void ProceduralDataGenerator::loadChunksData(const std::vector<glm::uvec2>& chunks)
+  {
+    // Chunks already generated in the background are published by swapping their buffers in,
+    // the replaced buffers are kept for later prefetches
+    std::vector<glm::uvec2> chunksToGenerate;
+    bool prefetchUsed = false;
+
+    for (const glm::uvec2& chunk : chunks)
+    {
+      if (takePrefetchedData(getChunkOffset(chunk.x, chunk.y), chunksData[chunk.y * chunksPerSide + chunk.x]))
+      {
+        prefetchUsed = true;
+      }
+      else
+      {
+        chunksToGenerate.push_back(chunk);
+      }
+    }
+
+    if (prefetchUsed)
+    {
+      for (ChunksPrefetch* prefetch : { &horizontalPrefetch, &verticalPrefetch })
+      {
+        if (prefetch->isReady() && std::find(prefetch->chunksData.begin(), prefetch->chunksData.end(), nullptr) != prefetch->chunksData.end())
+        {
+          releasePrefetch(*prefetch);
+        }
+      }
+    }
+
+    // Chunks don't share any state, so each one can be filled on its own thread. The call
+    // returns once every chunk is filled, before the update flags are set by the caller
+    threadPool.parallelFor(chunksToGenerate.size(), [this, &chunksToGenerate](uint32_t i)
+    {
+      loadChunkData(chunksToGenerate[i]);
+    });
+
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+      LOTUS_PROFILE_INCREASE_COUNTER(FrameCounter::ChunksLoaded);
+    }
+  }
+
   void ProceduralDataGenerator::loadChunkData(const glm::uvec2& chunk)
   {
     loadChunkData(chunk.x, chunk.y);
@@ -186,15 +509,72 @@ namespace Lotus
 
   void ProceduralDataGenerator::loadChunkData(uint8_t x, uint8_t y)
   {
-    glm::ivec2 dataChunk((x - getChunksLeft() + chunksPerSide) % chunksPerSide, (y - getChunksTop() + chunksPerSide) % chunksPerSide);
+    generateChunkData(getChunkOffset(x, y), chunksData[y * chunksPerSide + x]);
+  }
 
-    glm::ivec2 offset = dataOrigin - glm::ivec2((chunksPerSide * dataPerChunkSide) / 2) + dataChunk * static_cast<int>(dataPerChunkSide);
-    
-    float* chunkData = chunksData[y * chunksPerSide + x];
+  void ProceduralDataGenerator::generateChunkData(const glm::ivec2& offset, uint8_t* chunkData) const
+  {
+    PerlinNoiseConfig chunkNoiseConfig = noiseConfig;
+    chunkNoiseConfig.offset = offset;
+
+    if (dataFormat == ProceduralDataFormat::RUnsigned16)
+    {
+      uint16_t* quantizedData = reinterpret_cast<uint16_t*>(chunkData);
+
+      if (chunkCache && chunkCache->load(offset, quantizedData))
+      {
+        return;
+      }
+
+      // Noise is always evaluated in floating point, each thread keeps its own staging buffer
+      thread_local std::vector<float> stagingData;
+      stagingData.resize(dataPerChunkSide * dataPerChunkSide);
+
+      Perlin2DArray::fill(stagingData.data(), dataPerChunkSide, dataPerChunkSide, chunkNoiseConfig);
+
+      for (size_t i = 0; i < stagingData.size(); i++)
+      {
+        quantizedData[i] = quantizeUnorm16(stagingData[i]);
+      }
+
+      if (chunkCache)
+      {
+        chunkCache->store(offset, quantizedData);
+      }
+    }
+    else
+    {
+      float* floatData = reinterpret_cast<float*>(chunkData);
 
-    noiseConfig.offset = offset;
+      if (chunkCache && chunkCache->load(offset, floatData))
+      {
+        return;
+      }
+
+      Perlin2DArray::fill(floatData, dataPerChunkSide, dataPerChunkSide, chunkNoiseConfig);
 
-    Perlin2DArray::fill(chunkData, dataPerChunkSide, dataPerChunkSide, noiseConfig);
+      if (chunkCache)
+      {
+        chunkCache->store(offset, floatData);
+      }
+    }
+  }
+
+  uint8_t* ProceduralDataGenerator::allocateChunkData() const
+  {
+    return new uint8_t[dataPerChunkSide * dataPerChunkSide * getDataSize()];
+  }
+
+  glm::ivec2 ProceduralDataGenerator::getChunkOffset(uint8_t x, uint8_t y) const
+  {
+    glm::ivec2 dataChunk((x - getChunksLeft() + chunksPerSide) % chunksPerSide, (y - getChunksTop() + chunksPerSide) % chunksPerSide);
+
+    return getDataChunkOffset(dataOrigin, dataChunk);
+  }
+
+  glm::ivec2 ProceduralDataGenerator::getDataChunkOffset(const glm::ivec2& origin, const glm::ivec2& dataChunk) const
+  {
+    return origin - glm::ivec2((chunksPerSide * dataPerChunkSide) / 2) + dataChunk * static_cast<int>(dataPerChunkSide);
   }
 
 }
\ No newline at end of file
@@ -1,8 +1,13 @@
 #pragma once
 
 #include <vector>
+#include <atomic>
+#include <memory>
+#include <filesystem>
 #include "../math/types.h"
 #include "../math/noise.h"
+#include "../util/thread_pool.h"
+#include "chunk_cache.h"
 
 namespace Lotus
 {
@@ -15,14 +20,22 @@ namespace Lotus
     Everything
   };
 
+  enum class ProceduralDataFormat
+  {
+    RFloat,
+    RUnsigned16
+  };
+
   class ProceduralDataGenerator
   {
   public:
 
     ProceduralDataGenerator(
+        ThreadPool& engineThreadPool,
         uint16_t dataPerChunkSide,
         uint8_t chunksPerSide,
         const PerlinNoiseConfig& noiseConfig,
+        ProceduralDataFormat dataFormat = ProceduralDataFormat::RFloat,
         const glm::vec2& initialObserverPosition = { 0, 0 });
     ~ProceduralDataGenerator();
 
@@ -31,8 +44,15 @@ namespace Lotus
     uint32_t getDataAmount()       const { return dataPerChunkSide * chunksPerSide; }
     uint16_t getChunksAmount()     const { return chunksPerSide * chunksPerSide;    }
 
-    const float* getChunkData(const glm::uvec2& chunk) const;
-    const float* getChunkData(uint8_t x, uint8_t y) const;
+    ProceduralDataFormat getDataFormat() const { return dataFormat; }
+    size_t getDataSize() const { return dataFormat == ProceduralDataFormat::RUnsigned16 ? sizeof(uint16_t) : sizeof(float); }
+
+    // Raw chunk data, the element type depends on the data format
+    const void* getChunkData(const glm::uvec2& chunk) const;
+    const void* getChunkData(uint8_t x, uint8_t y) const;
+
+    // Value in [0, 1] of a single data point of a chunk, whatever the data format is
+    float getChunkValue(uint8_t x, uint8_t y, uint32_t dataIndex) const;
 
     glm::ivec2 getDataOrigin()   const { return dataOrigin;   }
     glm::uvec2 getChunksOrigin() const { return chunksOrigin; }
@@ -46,16 +66,49 @@ namespace Lotus
 
     void registerObserverPosition(const glm::vec2& observerPosition);
 
+    void setAsynchronousLoading(bool value) { asynchronousLoading = value; }
+    bool isAsynchronousLoading() const { return asynchronousLoading; }
+
+    void enableChunkCache(const std::filesystem::path& directory, bool quantized = false);
+    void disableChunkCache();
+
   private:
+
+    /*
+      Row or column of chunks generated in the background, ahead of the observer crossing into them
+    */
+    struct ChunksPrefetch
+    {
+      ProceduralUpdateRegion region = ProceduralUpdateRegion::Everything;
+      std::vector<glm::ivec2> offsets;
+      std::vector<uint8_t*> chunksData;
+      std::atomic<uint32_t> remaining = 0;
+      bool active = false;
+
+      bool isReady() const { return active && remaining == 0; }
+    };
+
+    void streamChunks(ChunksPrefetch& prefetch, float difference, float motion, ProceduralUpdateRegion positiveRegion, ProceduralUpdateRegion negativeRegion);
+    void requestPrefetch(ChunksPrefetch& prefetch, ProceduralUpdateRegion region);
+    void releasePrefetch(ChunksPrefetch& prefetch);
+    void waitPrefetch(ChunksPrefetch& prefetch);
+    bool takePrefetchedData(const glm::ivec2& offset, uint8_t*& chunkData);
     
     void reload(const glm::vec2& position);
+    void loadChunks(ProceduralUpdateRegion region);
     void loadTopChunks();
     void loadRightChunks();
     void loadBottomChunks();
     void loadLeftChunks();
 
+    void loadChunksData(const std::vector<glm::uvec2>& chunks);
     void loadChunkData(const glm::uvec2& chunk);
     void loadChunkData(uint8_t x, uint8_t y);
+    void generateChunkData(const glm::ivec2& offset, uint8_t* chunkData) const;
+    uint8_t* allocateChunkData() const;
+
+    glm::ivec2 getChunkOffset(uint8_t x, uint8_t y) const;
+    glm::ivec2 getDataChunkOffset(const glm::ivec2& origin, const glm::ivec2& dataChunk) const;
 
     uint16_t dataPerChunkSide;
     uint8_t chunksPerSide;
@@ -64,10 +117,22 @@ namespace Lotus
     glm::uvec2 chunksOrigin;
 
     PerlinNoiseConfig noiseConfig;
+    ProceduralDataFormat dataFormat;
 
     char stateSincePreviousFrame;
 
-    std::vector<float*> chunksData;
+    std::vector<uint8_t*> chunksData;
+
+    bool asynchronousLoading;
+    glm::vec2 previousObserverPosition;
+    ChunksPrefetch horizontalPrefetch;
+    ChunksPrefetch verticalPrefetch;
+    std::vector<uint8_t*> spareChunksData;
+
+    std::unique_ptr<ChunkCache> chunkCache;
+
+    // Shared with the rest of the engine, prefetches are queued behind its other tasks
+    ThreadPool& threadPool;
   };
 
 }
\ No newline at end of file
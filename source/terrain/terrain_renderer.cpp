@@ -57,7 +57,7 @@ namespace Lotus
     terrain = std::make_shared<Terrain>(terrainDataGenerator);
 
     Lotus::TextureConfig textureConfig;
-    textureConfig.format = Lotus::TextureFormat::RFloat;
+    textureConfig.format = terrainDataGenerator->getDataFormat() == ProceduralDataFormat::RUnsigned16 ? Lotus::TextureFormat::RUnsigned16 : Lotus::TextureFormat::RFloat;
     textureConfig.width = terrainDataGenerator->getDataPerChunkSide();
     textureConfig.height = terrainDataGenerator->getDataPerChunkSide();
     textureConfig.depth = terrainDataGenerator->getChunksAmount();
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <limits>
+#include <iterator>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace Lotus
+{
+
+  /*
+    Allocator of contiguous element ranges inside a growable linear space, like a GPU buffer.
+    Free blocks are indexed both by offset, to coalesce neighbours, and by size, to find the
+    best fitting block, so allocations and frees are O(log n) on the amount of free blocks
+  */
+  class BlockAllocator
+  {
+  public:
+
+    static constexpr uint32_t InvalidOffset = std::numeric_limits<uint32_t>::max();
+
+    // Displacement of a range of live elements done by compact()
+    struct Move
+    {
+      uint32_t source;
+      uint32_t destination;
+      size_t size;
+    };
+
+    BlockAllocator() : end(0), freeSize(0) {}
+
+    // Returns the first element of the new block, the space grows when no free block is large enough
+    uint32_t allocate(size_t size)
+    {
+      if (size == 0)
+      {
+        return InvalidOffset;
+      }
+
+      auto it = blocksBySize.lower_bound({ size, 0 });
+
+      if (it != blocksBySize.end())
+      {
+        const uint32_t first = it->second;
+        const size_t blockSize = it->first;
+
+        eraseBlock(first, blockSize);
+
+        if (blockSize > size)
+        {
+          insertBlock(first + static_cast<uint32_t>(size), blockSize - size);
+        }
+
+        return first;
+      }
+
+      // Free blocks never touch the end of the space, so the new block is appended
+      uint32_t first = static_cast<uint32_t>(end);
+
+      end = first + size;
+
+      return first;
+    }
+
+    // Returns false if the block is outside the allocated space or overlaps a free block
+    bool free(uint32_t first, size_t size)
+    {
+      if (size == 0 || first + size > end)
+      {
+        return false;
+      }
+
+      auto next = blocksByOffset.upper_bound(first);
+
+      if (next != blocksByOffset.end() && next->first < first + size)
+      {
+        return false;
+      }
+
+      if (next != blocksByOffset.begin())
+      {
+        auto previous = std::prev(next);
+
+        if (previous->first + previous->second > first)
+        {
+          return false;
+        }
+
+        // Coalesce with the previous block
+        if (previous->first + previous->second == first)
+        {
+          first = previous->first;
+          size += previous->second;
+          eraseBlock(previous->first, previous->second);
+        }
+      }
+
+      // Coalesce with the next block
+      if (next != blocksByOffset.end() && next->first == first + size)
+      {
+        size += next->second;
+        eraseBlock(next->first, next->second);
+      }
+
+      // Free space at the end is given back, so the end follows the live blocks
+      if (first + size == end)
+      {
+        end = first;
+        return true;
+      }
+
+      insertBlock(first, size);
+
+      return true;
+    }
+
+    // Packs the live elements at the beginning of the space, the moves are returned in offset order
+    std::vector<Move> compact()
+    {
+      std::vector<Move> moves;
+      moves.reserve(blocksByOffset.size() + 1);
+
+      uint32_t source = 0;
+      uint32_t destination = 0;
+
+      for (const auto& [first, size] : blocksByOffset)
+      {
+        if (first > source)
+        {
+          moves.push_back({ source, destination, first - source });
+          destination += first - source;
+        }
+
+        source = first + static_cast<uint32_t>(size);
+      }
+
+      if (end > source)
+      {
+        moves.push_back({ source, destination, end - source });
+        destination += static_cast<uint32_t>(end - source);
+      }
+
+      clear();
+      end = destination;
+
+      return moves;
+    }
+
+    // Offset after compact() of an element which was live before it
+    static uint32_t relocate(const std::vector<Move>& moves, uint32_t offset)
+    {
+      auto it = std::upper_bound(moves.begin(), moves.end(), offset, [](uint32_t value, const Move& move) { return value < move.source; });
+
+      if (it == moves.begin() || offset >= std::prev(it)->source + std::prev(it)->size)
+      {
+        return offset;
+      }
+
+      --it;
+
+      return it->destination + (offset - it->source);
+    }
+
+    void clear()
+    {
+      blocksByOffset.clear();
+      blocksBySize.clear();
+      end = 0;
+      freeSize = 0;
+    }
+
+    // One past the last element in use
+    size_t getEnd() const { return end; }
+
+    // Elements inside [0, end) not in use
+    size_t getFreeSize() const { return freeSize; }
+
+    size_t getFreeBlocksCount() const { return blocksByOffset.size(); }
+
+    const std::map<uint32_t, size_t>& getFreeBlocks() const { return blocksByOffset; }
+
+  private:
+
+    void insertBlock(uint32_t first, size_t size)
+    {
+      blocksByOffset.emplace(first, size);
+      blocksBySize.emplace(size, first);
+      freeSize += size;
+    }
+
+    void eraseBlock(uint32_t first, size_t size)
+    {
+      blocksByOffset.erase(first);
+      blocksBySize.erase({ size, first });
+      freeSize -= size;
+    }
+
+    std::map<uint32_t, size_t> blocksByOffset;
+    std::set<std::pair<size_t, uint32_t>> blocksBySize;
+    size_t end;
+    size_t freeSize;
+  };
+
+}
\ No newline at end of file
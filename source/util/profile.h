@@ -31,6 +31,7 @@ namespace Lotus
     DataGenerationTime,
     TerrainRenderTime,
     ObjectsPlacesGenerationTime,
+    IndirectObjectCullingTime,
     FrameTimeCount
   };
 
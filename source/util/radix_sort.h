@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <utility>
+#include <vector>
+
+namespace Lotus
+{
+
+  /*
+    Stable least significant digit radix sort by a 64 bit key, one byte per pass.
+    Histograms of every byte are counted in a single read of the values, and passes where all the
+    keys share the same byte are skipped, so keys only using their low bytes need fewer passes
+  */
+  template <typename T, typename KeyFunction>
+  void radixSort(std::vector<T>& values, std::vector<T>& scratch, KeyFunction&& key)
+  {
+    constexpr int DigitBits = 8;
+    constexpr int DigitsCount = 1 << DigitBits;
+    constexpr int PassesCount = 64 / DigitBits;
+
+    const size_t count = values.size();
+
+    if (count < 2)
+    {
+      return;
+    }
+
+    std::array<std::array<size_t, DigitsCount>, PassesCount> histograms = {};
+
+    for (const T& value : values)
+    {
+      const uint64_t valueKey = key(value);
+
+      for (int pass = 0; pass < PassesCount; pass++)
+      {
+        histograms[pass][(valueKey >> (pass * DigitBits)) & (DigitsCount - 1)]++;
+      }
+    }
+
+    scratch.resize(count);
+
+    for (int pass = 0; pass < PassesCount; pass++)
+    {
+      const int shift = pass * DigitBits;
+      std::array<size_t, DigitsCount>& histogram = histograms[pass];
+
+      if (histogram[(key(values[0]) >> shift) & (DigitsCount - 1)] == count)
+      {
+        continue;
+      }
+
+      // Bucket counts become the first place of each bucket
+      size_t offset = 0;
+
+      for (size_t& bucket : histogram)
+      {
+        const size_t bucketCount = bucket;
+        bucket = offset;
+        offset += bucketCount;
+      }
+
+      for (T& value : values)
+      {
+        scratch[histogram[(key(value) >> shift) & (DigitsCount - 1)]++] = std::move(value);
+      }
+
+      values.swap(scratch);
+    }
+  }
+
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace Lotus
+{
+
+  /*
+    Fixed size pool of worker threads consuming tasks from a shared queue
+  */
+  class ThreadPool
+  {
+  public:
+
+    ThreadPool(uint32_t threadsCount = defaultThreadsCount()) :
+      stopping(false)
+    {
+      workers.reserve(threadsCount);
+
+      for (uint32_t i = 0; i < threadsCount; i++)
+      {
+        workers.emplace_back([this]() { work(); });
+      }
+    }
+
+    ~ThreadPool()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+
+      condition.notify_all();
+
+      for (std::thread& worker : workers)
+      {
+        worker.join();
+      }
+    }
+
+    ThreadPool(const ThreadPool& threadPool) = delete;
+
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+    uint32_t getThreadsCount() const { return workers.size(); }
+
+    void submit(std::function<void()> task)
+    {
+      // Without workers the task would never run, so it is run right away
+      if (workers.empty())
+      {
+        task();
+        return;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(std::move(task));
+      }
+
+      condition.notify_one();
+    }
+
+    // Calls function(i) for every i in [0, count), returning only once all of the calls finished.
+    // The calling thread takes part in the work, so this never waits on tasks queued before it
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)>& function)
+    {
+      if (count == 0)
+      {
+        return;
+      }
+
+      struct ParallelForState
+      {
+        std::atomic<uint32_t> next = 0;
+        std::atomic<uint32_t> remaining = 0;
+        std::mutex mutex;
+        std::condition_variable finished;
+      };
+
+      std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+      state->remaining = count;
+
+      auto runIndices = [state, count, &function]()
+      {
+        for (uint32_t i = state->next++; i < count; i = state->next++)
+        {
+          function(i);
+
+          if (--state->remaining == 0)
+          {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->finished.notify_all();
+          }
+        }
+      };
+
+      uint32_t helpers = std::min(getThreadsCount(), count - 1);
+
+      for (uint32_t i = 0; i < helpers; i++)
+      {
+        submit(runIndices);
+      }
+
+      runIndices();
+
+      std::unique_lock<std::mutex> lock(state->mutex);
+      state->finished.wait(lock, [&state]() { return state->remaining == 0; });
+    }
+
+    static uint32_t defaultThreadsCount()
+    {
+      // The thread using the pool is expected to work too
+      return std::max(std::thread::hardware_concurrency(), 1u) - 1;
+    }
+
+  private:
+
+    void work()
+    {
+      while (true)
+      {
+        std::function<void()> task;
+
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+          if (stopping && tasks.empty())
+          {
+            return;
+          }
+
+          task = std::move(tasks.front());
+          tasks.pop();
+        }
+
+        task();
+      }
+    }
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping;
+  };
+
+}
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "unit_test.h"
+#include "util/block_allocator.h"
+
+struct Block
+{
+  uint32_t first;
+  size_t size;
+};
+
+// Free blocks must be disjoint, not adjacent and inside the space, and live blocks must not overlap them
+bool isConsistent(const Lotus::BlockAllocator& allocator, const std::vector<Block>& liveBlocks)
+{
+  size_t previousEnd = 0;
+  size_t freeSize = 0;
+  bool first = true;
+
+  for (const auto& [offset, size] : allocator.getFreeBlocks())
+  {
+    if (!first && offset <= previousEnd)
+    {
+      return false;
+    }
+
+    previousEnd = offset + size;
+    freeSize += size;
+    first = false;
+  }
+
+  if (previousEnd >= allocator.getEnd() && !allocator.getFreeBlocks().empty())
+  {
+    return false;
+  }
+
+  size_t liveSize = 0;
+
+  for (const Block& block : liveBlocks)
+  {
+    liveSize += block.size;
+
+    if (block.first + block.size > allocator.getEnd())
+    {
+      return false;
+    }
+  }
+
+  // Live and free elements cover the whole space exactly once
+  return freeSize == allocator.getFreeSize() && liveSize + freeSize == allocator.getEnd();
+}
+
+int main()
+{
+  UnitTest test("Block Allocator");
+
+  {
+    Lotus::BlockAllocator allocator;
+
+    uint32_t a = allocator.allocate(10);
+    uint32_t b = allocator.allocate(20);
+    uint32_t c = allocator.allocate(30);
+
+    test.expect(a == 0 && b == 10 && c == 30, "Blocks are appended when there is no free space");
+    test.expect(allocator.getEnd() == 60, "End follows the appended blocks");
+
+    test.expect(allocator.free(b, 20), "Live block can be freed");
+    test.expect(!allocator.free(b, 20), "Free block can't be freed twice");
+    test.expect(!allocator.free(15, 2), "Block inside a free region can't be freed");
+    test.expect(!allocator.free(60, 5), "Block outside the space can't be freed");
+
+    test.expect(allocator.allocate(5) == 10, "Free block is reused");
+    test.expect(allocator.getFreeBlocksCount() == 1 && allocator.getFreeSize() == 15, "Remainder of the reused block stays free");
+
+    test.expect(allocator.free(0, 10), "First block can be freed");
+    test.expect(allocator.free(10, 5), "Reused block can be freed");
+    test.expect(allocator.getFreeBlocksCount() == 1 && allocator.getFreeBlocks().begin()->second == 30, "Neighbour free blocks are coalesced");
+
+    test.expect(allocator.allocate(31) == 60, "Blocks larger than every free block are appended");
+
+    test.expect(allocator.free(60, 31), "Last block can be freed");
+    test.expect(allocator.getEnd() == 60, "Free space at the end is trimmed");
+
+    test.expect(allocator.free(30, 30), "Block before the end can be freed");
+    test.expect(allocator.getEnd() == 0 && allocator.getFreeBlocksCount() == 0, "Trimming absorbs the free blocks touching the end");
+  }
+
+  {
+    Lotus::BlockAllocator allocator;
+
+    test.expect(allocator.allocate(8) == 0 && allocator.allocate(4) == 8 && allocator.allocate(16) == 12 && allocator.allocate(6) == 28, "Blocks are appended");
+
+    allocator.free(0, 8);
+    allocator.free(12, 16);
+
+    test.expect(allocator.allocate(6) == 0, "Smallest fitting free block is used");
+    test.expect(allocator.allocate(9) == 12, "Larger requests skip the small free blocks");
+  }
+
+  {
+    Lotus::BlockAllocator allocator;
+
+    allocator.allocate(10);
+    allocator.allocate(5);
+    allocator.allocate(20);
+    allocator.allocate(7);
+
+    allocator.free(10, 5);
+    allocator.free(0, 10);
+
+    std::vector<Lotus::BlockAllocator::Move> moves = allocator.compact();
+
+    test.expect(moves.size() == 1 && moves[0].source == 15 && moves[0].destination == 0 && moves[0].size == 27, "Contiguous live blocks move as one range");
+    test.expect(allocator.getEnd() == 27 && allocator.getFreeBlocksCount() == 0, "Compaction leaves no free blocks");
+    test.expect(Lotus::BlockAllocator::relocate(moves, 15) == 0 && Lotus::BlockAllocator::relocate(moves, 35) == 20, "Live offsets are relocated");
+    test.expect(allocator.allocate(3) == 27, "Blocks are appended after the compacted ones");
+
+    allocator.free(0, 20);
+    moves = allocator.compact();
+
+    test.expect(moves.size() == 1 && Lotus::BlockAllocator::relocate(moves, 20) == 0 && Lotus::BlockAllocator::relocate(moves, 27) == 7, "Blocks after a leading hole are relocated");
+    test.expect(allocator.getEnd() == 10, "End follows the live elements");
+  }
+
+  {
+    Lotus::BlockAllocator allocator;
+    std::vector<Block> liveBlocks;
+    std::mt19937 random(42);
+
+    bool consistent = true;
+
+    for (int i = 0; i < 20000 && consistent; i++)
+    {
+      if (liveBlocks.empty() || random() % 3 != 0)
+      {
+        size_t size = 1 + random() % 64;
+        liveBlocks.push_back({ allocator.allocate(size), size });
+      }
+      else
+      {
+        size_t index = random() % liveBlocks.size();
+        consistent = allocator.free(liveBlocks[index].first, liveBlocks[index].size);
+
+        liveBlocks[index] = liveBlocks.back();
+        liveBlocks.pop_back();
+      }
+
+      consistent = consistent && isConsistent(allocator, liveBlocks);
+    }
+
+    test.expect(consistent, "Random allocations and frees keep the allocator consistent");
+
+    std::sort(liveBlocks.begin(), liveBlocks.end(), [](const Block& a, const Block& b) { return a.first < b.first; });
+
+    bool disjoint = true;
+
+    for (size_t i = 1; i < liveBlocks.size(); i++)
+    {
+      disjoint = disjoint && liveBlocks[i - 1].first + liveBlocks[i - 1].size <= liveBlocks[i].first;
+    }
+
+    test.expect(disjoint, "Live blocks never overlap");
+
+    std::vector<Lotus::BlockAllocator::Move> moves = allocator.compact();
+
+    size_t liveEnd = 0;
+
+    for (Block& block : liveBlocks)
+    {
+      block.first = Lotus::BlockAllocator::relocate(moves, block.first);
+      liveEnd += block.size;
+    }
+
+    bool packed = allocator.getEnd() == liveEnd;
+
+    for (size_t i = 1; i < liveBlocks.size(); i++)
+    {
+      packed = packed && liveBlocks[i - 1].first + liveBlocks[i - 1].size == liveBlocks[i].first;
+    }
+
+    test.expect(packed && (liveBlocks.empty() || liveBlocks[0].first == 0), "Compaction packs the live blocks keeping their order");
+
+    for (const Block& block : liveBlocks)
+    {
+      allocator.free(block.first, block.size);
+    }
+
+    test.expect(allocator.getEnd() == 0 && allocator.getFreeBlocksCount() == 0, "Freeing every block empties the allocator");
+  }
+
+  return test.result();
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "unit_test.h"
+#include "math/quantization.h"
+#include "terrain/chunk_cache.h"
+
+constexpr uint16_t DataPerChunkSide = 32;
+constexpr size_t DataAmount = DataPerChunkSide * DataPerChunkSide;
+
+int main()
+{
+  UnitTest test("Chunk Cache");
+
+  const std::filesystem::path directory = std::filesystem::temp_directory_path() / "lotus_chunk_cache_test";
+
+  std::error_code error;
+  std::filesystem::remove_all(directory, error);
+
+  std::mt19937 generator(13);
+  std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+
+  std::vector<float> floatData(DataAmount);
+  std::vector<uint16_t> quantizedData(DataAmount);
+
+  for (size_t i = 0; i < DataAmount; i++)
+  {
+    floatData[i] = unitDistribution(generator);
+    quantizedData[i] = static_cast<uint16_t>(generator());
+  }
+
+  Lotus::PerlinNoiseConfig noiseConfig;
+  noiseConfig.seed = 7;
+
+  // Float chunks are read back unchanged
+  const Lotus::ChunkCache floatCache(directory, noiseConfig, DataPerChunkSide);
+  const glm::ivec2 offset(3, -2);
+
+  floatCache.store(offset, floatData.data());
+
+  std::vector<float> loadedFloatData(DataAmount);
+
+  test.expect(floatCache.load(offset, loadedFloatData.data()), "Stored float chunk is not loaded");
+  test.expect(loadedFloatData == floatData, "Loaded float chunk differs from the stored one");
+  test.expect(!floatCache.load(glm::ivec2(3, 2), loadedFloatData.data()), "Chunk never stored is loaded");
+
+  // R16 chunks are read back unchanged, and as their dequantized values when loaded as floats
+  const Lotus::ChunkCache quantizedCache(directory, noiseConfig, DataPerChunkSide, true);
+
+  test.expect(quantizedCache.getDirectory() != floatCache.getDirectory(), "Float and R16 chunks share their directory");
+
+  quantizedCache.store(offset, quantizedData.data());
+
+  std::vector<uint16_t> loadedQuantizedData(DataAmount);
+
+  test.expect(quantizedCache.load(offset, loadedQuantizedData.data()), "Stored R16 chunk is not loaded");
+  test.expect(loadedQuantizedData == quantizedData, "Loaded R16 chunk differs from the stored one");
+
+  test.expect(quantizedCache.load(offset, loadedFloatData.data()), "Stored R16 chunk is not loaded as floats");
+
+  bool dequantizedMatch = true;
+
+  for (size_t i = 0; i < DataAmount; i++)
+  {
+    dequantizedMatch = dequantizedMatch && loadedFloatData[i] == Lotus::dequantizeUnorm16(quantizedData[i]);
+  }
+
+  test.expect(dequantizedMatch, "R16 chunk loaded as floats is not dequantized");
+
+  // Changing the configuration misses the stored chunks
+  Lotus::PerlinNoiseConfig changedConfigs[3] = { noiseConfig, noiseConfig, noiseConfig };
+  changedConfigs[0].seed++;
+  changedConfigs[1].frequency *= 2.0;
+  changedConfigs[2].octaves--;
+
+  for (const Lotus::PerlinNoiseConfig& changedConfig : changedConfigs)
+  {
+    const Lotus::ChunkCache changedCache(directory, changedConfig, DataPerChunkSide);
+
+    test.expect(!changedCache.load(offset, loadedFloatData.data()), "Chunk is loaded with a changed configuration");
+  }
+
+  const Lotus::ChunkCache resizedCache(directory, noiseConfig, DataPerChunkSide / 2);
+
+  test.expect(!resizedCache.load(offset, loadedFloatData.data()), "Chunk is loaded with a changed chunk size");
+
+  // Values clamped by the noise generation give the same data, so they share the chunks
+  Lotus::PerlinNoiseConfig clampedConfig = noiseConfig;
+  Lotus::PerlinNoiseConfig outOfRangeConfig = noiseConfig;
+  clampedConfig.frequency = 64.0;
+  clampedConfig.octaves = 16;
+  outOfRangeConfig.frequency = 100.0;
+  outOfRangeConfig.octaves = 40;
+
+  const Lotus::ChunkCache clampedCache(directory, clampedConfig, DataPerChunkSide);
+  const Lotus::ChunkCache outOfRangeCache(directory, outOfRangeConfig, DataPerChunkSide);
+
+  test.expect(clampedCache.getDirectory() == outOfRangeCache.getDirectory(), "Out of range noise settings are not hashed clamped");
+
+  // Files written with another version miss, the version follows the 4 bytes of the magic in the header
+  {
+    std::fstream file(floatCache.getDirectory() / "3_-2.chunk", std::ios::binary | std::ios::in | std::ios::out);
+
+    uint32_t version;
+    file.seekg(4);
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+
+    version++;
+    file.seekp(4);
+    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+  }
+
+  test.expect(!floatCache.load(offset, loadedFloatData.data()), "Chunk is loaded with a changed version");
+
+  std::filesystem::remove_all(directory, error);
+
+  return test.result();
+}
\ No newline at end of file
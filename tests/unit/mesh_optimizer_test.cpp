@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include "unit_test.h"
+#include "render/mesh_optimizer.h"
+#include "test_meshes.h"
+
+// Triangles as position triplets starting at their smallest position, so the winding is kept, sorted
+std::vector<std::array<float, 9>> sortedTriangles(const std::vector<Lotus::MeshVertex>& vertices, const std::vector<unsigned int>& indices)
+{
+  std::vector<std::array<float, 9>> triangles;
+
+  for (size_t i = 0; i < indices.size(); i += 3)
+  {
+    std::array<std::array<float, 3>, 3> corners;
+
+    for (int corner = 0; corner < 3; corner++)
+    {
+      const glm::vec3& position = vertices[indices[i + corner]].position;
+      corners[corner] = { position.x, position.y, position.z };
+    }
+
+    std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+
+    std::array<float, 9> triangle;
+
+    for (int corner = 0; corner < 3; corner++)
+    {
+      std::copy(corners[corner].begin(), corners[corner].end(), triangle.begin() + corner * 3);
+    }
+
+    triangles.push_back(triangle);
+  }
+
+  std::sort(triangles.begin(), triangles.end());
+
+  return triangles;
+}
+
+int main()
+{
+  UnitTest test("Mesh Optimizer");
+
+  std::mt19937 generator(3);
+
+  // Statistics of a single triangle, every vertex is transformed once
+  Lotus::VertexCacheStatistics triangleStatistics = Lotus::MeshOptimizer::analyzeVertexCache({ 0, 1, 2 }, 3);
+
+  test.expect(triangleStatistics.transformedVertices == 3, "Single triangle transformed " + std::to_string(triangleStatistics.transformedVertices) + " vertices");
+  test.expect(triangleStatistics.acmr == 3.0f && triangleStatistics.atvr == 1.0f, "Single triangle has wrong ACMR or ATVR");
+
+  TestMesh sphere = createSphere(32, 64);
+  shuffleMesh(sphere, generator);
+  const std::vector<std::array<float, 9>> triangles = sortedTriangles(sphere.vertices, sphere.indices);
+
+  Lotus::VertexCacheStatistics shuffledStatistics = Lotus::MeshOptimizer::analyzeVertexCache(sphere.indices, sphere.vertices.size());
+
+  // Vertex cache order
+  std::vector<unsigned int> cacheIndices = sphere.indices;
+  std::vector<uint32_t> clusterOffsets;
+  Lotus::MeshOptimizer::optimizeVertexCache(cacheIndices, sphere.vertices.size(), Lotus::MeshOptimizer::DefaultCacheSize, clusterOffsets);
+
+  Lotus::VertexCacheStatistics cacheStatistics = Lotus::MeshOptimizer::analyzeVertexCache(cacheIndices, sphere.vertices.size());
+
+  test.expect(sortedTriangles(sphere.vertices, cacheIndices) == triangles, "Vertex cache order changed the triangles");
+  test.expect(cacheStatistics.acmr < 0.8f, "Vertex cache order ACMR is " + std::to_string(cacheStatistics.acmr));
+  test.expect(cacheStatistics.acmr < shuffledStatistics.acmr / 2.0f, "Vertex cache order ACMR " + std::to_string(cacheStatistics.acmr) + " did not improve enough");
+  test.expect(cacheStatistics.atvr < 1.4f, "Vertex cache order ATVR is " + std::to_string(cacheStatistics.atvr));
+  test.expect(!clusterOffsets.empty() && clusterOffsets[0] == 0 && std::is_sorted(clusterOffsets.begin(), clusterOffsets.end()), "Clusters are not in order");
+
+  // Overdraw order keeps most of the vertex cache efficiency
+  std::vector<unsigned int> overdrawIndices = cacheIndices;
+  Lotus::MeshOptimizer::optimizeOverdraw(sphere.vertices, overdrawIndices, clusterOffsets);
+
+  Lotus::VertexCacheStatistics overdrawStatistics = Lotus::MeshOptimizer::analyzeVertexCache(overdrawIndices, sphere.vertices.size());
+
+  test.expect(sortedTriangles(sphere.vertices, overdrawIndices) == triangles, "Overdraw order changed the triangles");
+  test.expect(overdrawStatistics.acmr < cacheStatistics.acmr * 1.25f, "Overdraw order ACMR " + std::to_string(overdrawStatistics.acmr) + " is much worse");
+
+  // Vertex fetch order, vertices are first used in increasing order
+  std::vector<Lotus::MeshVertex> fetchVertices = sphere.vertices;
+  std::vector<unsigned int> fetchIndices = overdrawIndices;
+  Lotus::MeshOptimizer::optimizeVertexFetch(fetchVertices, fetchIndices);
+
+  bool fetchedInOrder = true;
+  unsigned int nextVertex = 0;
+
+  for (unsigned int index : fetchIndices)
+  {
+    fetchedInOrder = fetchedInOrder && index <= nextVertex;
+    nextVertex = std::max(nextVertex, index + 1);
+  }
+
+  test.expect(fetchedInOrder, "Vertices are not in order of first use");
+  test.expect(fetchVertices.size() == sphere.vertices.size(), "Vertex fetch order changed the amount of vertices");
+  test.expect(sortedTriangles(fetchVertices, fetchIndices) == triangles, "Vertex fetch order changed the triangles");
+
+  // Unused vertices are dropped
+  std::vector<Lotus::MeshVertex> unusedVertices = sphere.vertices;
+  std::vector<unsigned int> partialIndices(sphere.indices.begin(), sphere.indices.begin() + 3);
+  Lotus::MeshOptimizer::optimizeVertexFetch(unusedVertices, partialIndices);
+
+  test.expect(unusedVertices.size() == 3 && partialIndices == std::vector<unsigned int>({ 0, 1, 2 }), "Unused vertices were kept");
+
+  // Whole pipeline
+  std::vector<Lotus::MeshVertex> optimizedVertices = sphere.vertices;
+  std::vector<unsigned int> optimizedIndices = sphere.indices;
+  Lotus::MeshOptimizer::optimize(optimizedVertices, optimizedIndices);
+
+  Lotus::VertexCacheStatistics optimizedStatistics = Lotus::MeshOptimizer::analyzeVertexCache(optimizedIndices, optimizedVertices.size());
+
+  test.expect(sortedTriangles(optimizedVertices, optimizedIndices) == triangles, "Optimization changed the triangles");
+  test.expect(optimizedStatistics.acmr == overdrawStatistics.acmr, "Vertex fetch order changed the ACMR");
+
+  // Welding a sphere with a vertex per triangle corner and slightly moved positions recovers the shared vertices,
+  // except along the UV seam and at the poles, where the UVs differ
+  std::vector<Lotus::MeshVertex> cornerVertices;
+  std::vector<unsigned int> cornerIndices;
+  std::uniform_real_distribution<float> jitter(-1e-7f, 1e-7f);
+
+  for (unsigned int index : sphere.indices)
+  {
+    Lotus::MeshVertex vertex = sphere.vertices[index];
+    vertex.position += glm::vec3(jitter(generator), jitter(generator), jitter(generator));
+
+    cornerIndices.push_back(static_cast<unsigned int>(cornerVertices.size()));
+    cornerVertices.push_back(vertex);
+  }
+
+  Lotus::MeshOptimizer::weldVertices(cornerVertices, cornerIndices);
+
+  test.expect(cornerVertices.size() == sphere.vertices.size(), "Welding kept " + std::to_string(cornerVertices.size()) + " vertices");
+  test.expect(cornerIndices.size() == sphere.indices.size(), "Welding changed the amount of triangles");
+
+  // Vertices on a normal crease are kept apart, and triangles collapsed by the welding are removed
+  std::vector<Lotus::MeshVertex> creaseVertices(7);
+
+  creaseVertices[0].position = glm::vec3(0.0f, 0.0f, 0.0f);
+  creaseVertices[1].position = glm::vec3(1.0f, 0.0f, 0.0f);
+  creaseVertices[2].position = glm::vec3(0.0f, 0.0f, 1.0f);
+  creaseVertices[3].position = glm::vec3(0.0f, 0.0f, 0.0f);
+  creaseVertices[4].position = glm::vec3(0.0f, 1.0f, 0.0f);
+  creaseVertices[5].position = glm::vec3(0.0f, 0.0f, 1.0f);
+  creaseVertices[6].position = glm::vec3(0.0f, 0.0f, 1e-7f);
+
+  for (int i = 0; i < 7; i++)
+  {
+    creaseVertices[i].normal = i < 3 || i == 6 ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+    creaseVertices[i].uv = glm::vec2(0.0f);
+    creaseVertices[i].tangent = glm::vec3(0.0f);
+    creaseVertices[i].bitangent = glm::vec3(0.0f);
+  }
+
+  std::vector<unsigned int> creaseIndices = { 0, 2, 1, 3, 4, 5, 0, 6, 2 };
+  Lotus::MeshOptimizer::weldVertices(creaseVertices, creaseIndices);
+
+  test.expect(creaseVertices.size() == 6, "Welding across a crease kept " + std::to_string(creaseVertices.size()) + " vertices");
+  test.expect(creaseIndices == std::vector<unsigned int>({ 0, 2, 1, 3, 4, 5 }), "Welding kept a collapsed triangle");
+
+  return test.result();
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "unit_test.h"
+#include "render/mesh_simplifier.h"
+#include "render/mesh_optimizer.h"
+#include "test_meshes.h"
+
+// Flat square grid on the XZ plane, with open borders
+TestMesh createGrid(int cells)
+{
+  TestMesh mesh;
+
+  for (int z = 0; z <= cells; z++)
+  {
+    for (int x = 0; x <= cells; x++)
+    {
+      Lotus::MeshVertex vertex;
+      vertex.position = glm::vec3(static_cast<float>(x) / cells, 0.0f, static_cast<float>(z) / cells);
+      vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+      vertex.uv = glm::vec2(vertex.position.x, vertex.position.z);
+      vertex.tangent = glm::vec3(0.0f);
+      vertex.bitangent = glm::vec3(0.0f);
+
+      mesh.vertices.push_back(vertex);
+    }
+  }
+
+  for (int z = 0; z < cells; z++)
+  {
+    for (int x = 0; x < cells; x++)
+    {
+      unsigned int a = z * (cells + 1) + x;
+      unsigned int b = a + cells + 1;
+
+      mesh.indices.insert(mesh.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+    }
+  }
+
+  return mesh;
+}
+
+// Largest distance from the triangle centroids to the unit sphere
+float maxSphereDeviation(const std::vector<Lotus::MeshVertex>& vertices, const std::vector<unsigned int>& indices)
+{
+  float deviation = 0.0f;
+
+  for (size_t i = 0; i < indices.size(); i += 3)
+  {
+    glm::vec3 centroid = (vertices[indices[i]].position + vertices[indices[i + 1]].position + vertices[indices[i + 2]].position) / 3.0f;
+
+    deviation = std::max(deviation, std::abs(1.0f - glm::length(centroid)));
+  }
+
+  return deviation;
+}
+
+// Sum of the triangle areas projected on the XZ plane, which is 1 for the whole grid
+float projectedArea(const std::vector<Lotus::MeshVertex>& vertices, const std::vector<unsigned int>& indices)
+{
+  float area = 0.0f;
+
+  for (size_t i = 0; i < indices.size(); i += 3)
+  {
+    glm::vec3 e0 = vertices[indices[i + 1]].position - vertices[indices[i]].position;
+    glm::vec3 e1 = vertices[indices[i + 2]].position - vertices[indices[i]].position;
+
+    area += 0.5f * std::abs(e0.z * e1.x - e0.x * e1.z);
+  }
+
+  return area;
+}
+
+int main()
+{
+  UnitTest test("Mesh Simplifier");
+
+  // Curved surface, the triangle ratio is reached within the error limit
+  TestMesh sphere = createSphere(32, 64);
+
+  for (float ratio : { 0.5f, 0.25f, 0.1f })
+  {
+    Lotus::MeshSimplificationConfig config;
+    config.triangleRatio = ratio;
+    config.maxError = 0.05f;
+
+    float error = 0.0f;
+    std::vector<unsigned int> indices = Lotus::MeshSimplifier::simplify(sphere.vertices, sphere.indices, config, &error);
+
+    const std::string name = "Sphere at ratio " + std::to_string(ratio);
+    const size_t targetIndicesCount = static_cast<size_t>(sphere.indices.size() / 3 * ratio) * 3;
+
+    test.expect(indices.size() % 3 == 0, name + " has incomplete triangles");
+    test.expect(indices.size() <= targetIndicesCount, name + " kept " + std::to_string(indices.size() / 3) + " triangles");
+    test.expect(indices.size() >= targetIndicesCount * 3 / 4, name + " removed too many triangles");
+    test.expect(error <= config.maxError, name + " error " + std::to_string(error) + " is over the limit");
+
+    // Errors are relative to the largest side of the bounds, which is 2 for the unit sphere
+    float deviation = maxSphereDeviation(sphere.vertices, indices);
+
+    test.expect(deviation < 4.0f * config.maxError, name + " deviates " + std::to_string(deviation) + " from the sphere");
+
+    std::vector<unsigned int> compactedIndices = indices;
+    std::vector<Lotus::MeshVertex> compactedVertices = sphere.vertices;
+    Lotus::MeshOptimizer::optimizeVertexFetch(compactedVertices, compactedIndices);
+
+    bool sameTriangles = compactedIndices.size() == indices.size();
+
+    for (size_t i = 0; sameTriangles && i < indices.size(); i++)
+    {
+      sameTriangles = compactedVertices[compactedIndices[i]].position == sphere.vertices[indices[i]].position;
+    }
+
+    test.expect(compactedVertices.size() < sphere.vertices.size(), name + " vertices were not compacted");
+    test.expect(sameTriangles, name + " compacted triangles differ");
+  }
+
+  // A tight error limit stops the simplification of a curved surface early
+  Lotus::MeshSimplificationConfig tightConfig;
+  tightConfig.triangleRatio = 0.1f;
+  tightConfig.maxError = 1e-4f;
+
+  float tightError = 0.0f;
+  std::vector<unsigned int> tightIndices = Lotus::MeshSimplifier::simplify(sphere.vertices, sphere.indices, tightConfig, &tightError);
+
+  test.expect(tightIndices.size() > sphere.indices.size() / 2, "Sphere was simplified over the error limit");
+  test.expect(tightError <= tightConfig.maxError, "Sphere error " + std::to_string(tightError) + " is over the tight limit");
+
+  // Flat surface, it can be reduced a lot without any error while keeping its borders
+  TestMesh grid = createGrid(16);
+
+  Lotus::MeshSimplificationConfig gridConfig;
+  gridConfig.triangleRatio = 0.05f;
+  gridConfig.maxError = 1e-3f;
+
+  float gridError = 0.0f;
+  std::vector<unsigned int> gridIndices = Lotus::MeshSimplifier::simplify(grid.vertices, grid.indices, gridConfig, &gridError);
+
+  float area = projectedArea(grid.vertices, gridIndices);
+
+  test.expect(gridIndices.size() <= static_cast<size_t>(grid.indices.size() / 3 * gridConfig.triangleRatio) * 3, "Grid kept " + std::to_string(gridIndices.size() / 3) + " triangles");
+  test.expect(gridError <= gridConfig.maxError, "Grid error " + std::to_string(gridError) + " is over the limit");
+  test.expect(std::abs(area - 1.0f) < 1e-3f, "Grid area changed to " + std::to_string(area));
+
+  // Nothing to do when the ratio keeps every triangle
+  Lotus::MeshSimplificationConfig identityConfig;
+  identityConfig.triangleRatio = 1.0f;
+
+  test.expect(Lotus::MeshSimplifier::simplify(sphere.vertices, sphere.indices, identityConfig) == sphere.indices, "Simplification changed the mesh at ratio 1");
+
+  return test.result();
+}
\ No newline at end of file
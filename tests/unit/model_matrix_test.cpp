@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "unit_test.h"
+#include "math/model_matrix.h"
+
+constexpr float Tolerance = 1e-5f;
+
+// Translation * rotation * scale as composed by glm matrix products
+glm::mat4 referenceModelMatrix(const glm::vec3& translation, const glm::fquat& rotation, const glm::vec3& scale)
+{
+  return glm::translate(glm::mat4(1.0f), translation) * glm::toMat4(rotation) * glm::scale(glm::mat4(1.0f), scale);
+}
+
+float maxDifference(const glm::mat4& a, const glm::mat4& b)
+{
+  float difference = 0.0f;
+
+  for (int column = 0; column < 4; column++)
+  {
+    for (int row = 0; row < 4; row++)
+    {
+      difference = std::max(difference, std::abs(a[column][row] - b[column][row]));
+    }
+  }
+
+  return difference;
+}
+
+int main()
+{
+  UnitTest test("Model Matrix");
+
+  // Not a multiple of the vector width, so the scalar remainder is covered too
+  constexpr uint32_t ObjectsCount = 67;
+
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+  std::vector<glm::vec3> translations(ObjectsCount);
+  std::vector<glm::fquat> rotations(ObjectsCount);
+  std::vector<glm::vec3> scales(ObjectsCount);
+
+  for (uint32_t i = 0; i < ObjectsCount; i++)
+  {
+    translations[i] = 100.0f * glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+    rotations[i] = glm::normalize(glm::fquat(distribution(generator), distribution(generator), distribution(generator), distribution(generator)));
+    scales[i] = glm::vec3(distribution(generator), distribution(generator), distribution(generator)) + glm::vec3(1.5f);
+  }
+
+  // Every other object in reverse order, the kernel must follow the indices and not the arrays
+  std::vector<uint32_t> indices;
+
+  for (uint32_t i = ObjectsCount; i-- > 0;)
+  {
+    if (i % 2 == 0)
+    {
+      indices.push_back(i);
+    }
+  }
+
+  std::vector<uint32_t> visited;
+  float maxError = 0.0f;
+
+  Lotus::ModelMatrixKernel::compose(translations.data(), rotations.data(), scales.data(), indices.data(), indices.size(), [&](uint32_t i, const glm::mat4& model)
+  {
+    visited.push_back(i);
+    maxError = std::max(maxError, maxDifference(model, referenceModelMatrix(translations[i], rotations[i], scales[i])));
+  });
+
+  test.expect(visited == indices, "Output is not called once per index in order");
+  test.expect(maxError < Tolerance, "Batched matrices differ from reference by " + std::to_string(maxError));
+
+  // Single transforms go through the scalar path
+  maxError = 0.0f;
+
+  for (uint32_t i = 0; i < ObjectsCount; i++)
+  {
+    glm::mat4 model = Lotus::ModelMatrixKernel::compose(translations[i], rotations[i], scales[i]);
+
+    maxError = std::max(maxError, maxDifference(model, referenceModelMatrix(translations[i], rotations[i], scales[i])));
+  }
+
+  test.expect(maxError < Tolerance, "Single matrices differ from reference by " + std::to_string(maxError));
+
+  // Nothing is written for an empty batch
+  bool called = false;
+
+  Lotus::ModelMatrixKernel::compose(translations.data(), rotations.data(), scales.data(), indices.data(), 0, [&called](uint32_t, const glm::mat4&) { called = true; });
+
+  test.expect(!called, "Output called for an empty batch");
+
+  return test.result();
+}
\ No newline at end of file
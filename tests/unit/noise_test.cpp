@@ -0,0 +1,66 @@
+#include <cmath>
+#include <vector>
+#include "unit_test.h"
+#include "math/noise.h"
+
+constexpr float Tolerance = 1e-4f;
+
+// Largest difference between Perlin2DArray::fill and the siv::PerlinNoise scalar reference
+float maxReferenceError(int width, int height, const Lotus::PerlinNoiseConfig& noiseConfig)
+{
+  std::vector<float> data(width * height);
+
+  Lotus::Perlin2DArray::fill(data.data(), width, height, noiseConfig);
+
+  const siv::PerlinNoise perlin(noiseConfig.seed);
+
+  const double fx = noiseConfig.frequency / width;
+  const double fy = noiseConfig.frequency / height;
+
+  float maxError = 0.0f;
+
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x++)
+    {
+      double xSample = (x + noiseConfig.offset.x) * fx;
+      double ySample = (y + noiseConfig.offset.y) * fy;
+
+      double reference = perlin.normalizedOctave2D_01(xSample, ySample, noiseConfig.octaves);
+
+      maxError = std::max(maxError, static_cast<float>(std::abs(reference - data[y * width + x])));
+    }
+  }
+
+  return maxError;
+}
+
+int main()
+{
+  UnitTest test("Noise");
+
+  const glm::ivec2 offsets[] = { { 0, 0 }, { -1536, 2048 }, { 1000000, -777777 } };
+
+  for (int octaves : { 1, 4, 8 })
+  {
+    for (const glm::ivec2& offset : offsets)
+    {
+      Lotus::PerlinNoiseConfig noiseConfig;
+      noiseConfig.seed = 7;
+      noiseConfig.octaves = octaves;
+      noiseConfig.offset = offset;
+
+      float error = maxReferenceError(128, 64, noiseConfig);
+
+      test.expect(error < Tolerance, "Octaves " + std::to_string(octaves) + " at offset (" + std::to_string(offset.x) + ", " + std::to_string(offset.y) + ") differs from reference by " + std::to_string(error));
+    }
+  }
+
+  // Widths that are not a multiple of the vector width go through the scalar remainder
+  Lotus::PerlinNoiseConfig noiseConfig;
+  noiseConfig.offset = { 37, -5 };
+
+  test.expect(maxReferenceError(61, 3, noiseConfig) < Tolerance, "Remainder samples differ from reference");
+
+  return test.result();
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include "unit_test.h"
+#include "math/quantization.h"
+
+int main()
+{
+  UnitTest test("Quantization");
+
+  std::mt19937 generator(5);
+  std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+
+  // Signed normalized values, the error is at most half a step
+  float snormError = 0.0f;
+
+  for (int i = 0; i < 10000; i++)
+  {
+    const float value = unitDistribution(generator);
+    snormError = std::max(snormError, std::abs(Lotus::dequantizeSnorm16(Lotus::quantizeSnorm16(value)) - value));
+  }
+
+  test.expect(snormError <= 0.5f / 32767.0f + 1e-7f, "Snorm16 error is " + std::to_string(snormError));
+  test.expect(Lotus::quantizeSnorm16(1.0f) == 32767 && Lotus::quantizeSnorm16(-1.0f) == -32767, "Snorm16 range ends are not exact");
+  test.expect(Lotus::quantizeSnorm16(2.0f) == 32767 && Lotus::quantizeSnorm16(-2.0f) == -32767, "Snorm16 values out of range are not clamped");
+  test.expect(Lotus::dequantizeSnorm16(-32768) == -1.0f, "Snorm16 minimum is not -1");
+
+  // Half floats, normal values keep 11 significant bits
+  float halfRelativeError = 0.0f;
+  std::uniform_int_distribution<int> exponentDistribution(-14, 14);
+
+  for (int i = 0; i < 10000; i++)
+  {
+    const float value = (1.0f + std::abs(unitDistribution(generator))) * std::exp2(static_cast<float>(exponentDistribution(generator)));
+    halfRelativeError = std::max(halfRelativeError, std::abs(Lotus::dequantizeHalf(Lotus::quantizeHalf(value)) - value) / std::abs(value));
+  }
+
+  test.expect(halfRelativeError <= std::exp2(-11.0f), "Half relative error is " + std::to_string(halfRelativeError));
+
+  // Every half converts back to itself
+  bool halvesRoundTrip = true;
+
+  for (uint32_t bits = 0; bits <= 0xFFFF; bits++)
+  {
+    const uint16_t half = static_cast<uint16_t>(bits);
+    const bool isNaN = (half & 0x7C00) == 0x7C00 && (half & 0x3FF) != 0;
+
+    halvesRoundTrip = halvesRoundTrip && (isNaN ? std::isnan(Lotus::dequantizeHalf(half)) : Lotus::quantizeHalf(Lotus::dequantizeHalf(half)) == half);
+  }
+
+  test.expect(halvesRoundTrip, "Halves do not round trip");
+  test.expect(Lotus::quantizeHalf(1.0f) == 0x3C00 && Lotus::quantizeHalf(-2.0f) == 0xC000, "Half encodings of 1 and -2 are wrong");
+  test.expect(Lotus::quantizeHalf(65504.0f) == 0x7BFF && Lotus::quantizeHalf(65520.0f) == 0x7C00, "Half overflow is wrong");
+  test.expect(Lotus::quantizeHalf(std::numeric_limits<float>::infinity()) == 0x7C00, "Half infinity is wrong");
+  test.expect(Lotus::quantizeHalf(std::exp2(-24.0f)) == 0x0001 && Lotus::quantizeHalf(std::exp2(-26.0f)) == 0x0000, "Half subnormals are wrong");
+  test.expect(Lotus::quantizeHalf(1.0f + std::exp2(-11.0f)) == 0x3C00, "Half ties are not rounded to even");
+
+  // Octahedral directions, quantized as snorm16 the angular error stays far below what shading can show
+  float octahedralError = 0.0f;
+
+  for (int i = 0; i < 10000; i++)
+  {
+    const glm::vec3 direction = glm::normalize(glm::vec3(unitDistribution(generator), unitDistribution(generator), unitDistribution(generator)));
+
+    glm::vec2 encoded = Lotus::encodeOctahedral(direction);
+    encoded = glm::vec2(Lotus::dequantizeSnorm16(Lotus::quantizeSnorm16(encoded.x)), Lotus::dequantizeSnorm16(Lotus::quantizeSnorm16(encoded.y)));
+
+    const glm::vec3 decoded = Lotus::decodeOctahedral(encoded);
+
+    octahedralError = std::max(octahedralError, std::acos(std::clamp(glm::dot(decoded, direction), -1.0f, 1.0f)));
+  }
+
+  test.expect(octahedralError < 1e-3f, "Octahedral error is " + std::to_string(octahedralError) + " radians");
+
+  // Axes are exact, including the folded lower half
+  const glm::vec3 axes[] = { glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) };
+  bool axesExact = true;
+
+  for (const glm::vec3& axis : axes)
+  {
+    axesExact = axesExact && glm::length(Lotus::decodeOctahedral(Lotus::encodeOctahedral(axis)) - axis) < 1e-6f;
+  }
+
+  test.expect(axesExact, "Octahedral axes are not exact");
+
+  return test.result();
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "unit_test.h"
+#include "util/radix_sort.h"
+
+struct Entry
+{
+  uint64_t key;
+  uint32_t order;
+};
+
+// Sorted by key and, for equal keys, in their original order
+bool isStablySorted(const std::vector<Entry>& entries)
+{
+  for (size_t i = 1; i < entries.size(); i++)
+  {
+    const Entry& previous = entries[i - 1];
+    const Entry& current = entries[i];
+
+    if (previous.key > current.key || (previous.key == current.key && previous.order > current.order))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+std::vector<Entry> randomEntries(size_t count, uint64_t keyMask, std::mt19937_64& generator)
+{
+  std::vector<Entry> entries(count);
+
+  for (uint32_t i = 0; i < count; i++)
+  {
+    entries[i] = { generator() & keyMask, i };
+  }
+
+  return entries;
+}
+
+int main()
+{
+  UnitTest test("Radix Sort");
+
+  std::mt19937_64 generator(7);
+  std::vector<Entry> scratch;
+
+  auto getKey = [](const Entry& entry) { return entry.key; };
+
+  // Full keys, keys with only low bytes in use and keys with many repetitions
+  const uint64_t keyMasks[] = { ~0ull, 0xFFFFull, 0xFF000000000000FFull, 0x7ull };
+
+  for (uint64_t keyMask : keyMasks)
+  {
+    for (size_t count : { 0, 1, 2, 100, 5000 })
+    {
+      std::vector<Entry> entries = randomEntries(count, keyMask, generator);
+      std::vector<Entry> sortedEntries = entries;
+
+      Lotus::radixSort(sortedEntries, scratch, getKey);
+
+      std::vector<Entry> referenceEntries = entries;
+      std::stable_sort(referenceEntries.begin(), referenceEntries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+
+      bool sameEntries = std::equal(sortedEntries.begin(), sortedEntries.end(), referenceEntries.begin(), referenceEntries.end(),
+          [](const Entry& a, const Entry& b) { return a.key == b.key && a.order == b.order; });
+
+      const std::string name = std::to_string(count) + " keys with mask " + std::to_string(keyMask);
+
+      test.expect(sortedEntries.size() == count, name + " changed the amount of entries");
+      test.expect(isStablySorted(sortedEntries), name + " are not stably sorted");
+      test.expect(sameEntries, name + " differ from std::stable_sort");
+    }
+  }
+
+  // Already sorted input stays the same
+  std::vector<Entry> entries = randomEntries(1000, ~0ull, generator);
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+
+  std::vector<Entry> sortedEntries = entries;
+  Lotus::radixSort(sortedEntries, scratch, getKey);
+
+  test.expect(std::equal(sortedEntries.begin(), sortedEntries.end(), entries.begin(), entries.end(),
+      [](const Entry& a, const Entry& b) { return a.key == b.key && a.order == b.order; }), "Sorted input was reordered");
+
+  return test.result();
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "render/mesh.h"
+
+/*
+  Procedural meshes shared by the mesh processing tests
+*/
+struct TestMesh
+{
+  std::vector<Lotus::MeshVertex> vertices;
+  std::vector<unsigned int> indices;
+};
+
+// Unit sphere with a UV seam at longitude 0, where the first and last columns share positions
+inline TestMesh createSphere(int rings, int segments)
+{
+  TestMesh mesh;
+
+  for (int ring = 0; ring <= rings; ring++)
+  {
+    for (int segment = 0; segment <= segments; segment++)
+    {
+      float u = static_cast<float>(segment) / segments;
+      float v = static_cast<float>(ring) / rings;
+
+      float theta = u * 2.0f * glm::pi<float>();
+      float phi = v * glm::pi<float>();
+
+      Lotus::MeshVertex vertex;
+      vertex.position = glm::vec3(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+      vertex.normal = vertex.position;
+      vertex.uv = glm::vec2(u, v);
+      vertex.tangent = glm::vec3(0.0f);
+      vertex.bitangent = glm::vec3(0.0f);
+
+      mesh.vertices.push_back(vertex);
+    }
+  }
+
+  for (int ring = 0; ring < rings; ring++)
+  {
+    for (int segment = 0; segment < segments; segment++)
+    {
+      unsigned int a = ring * (segments + 1) + segment;
+      unsigned int b = a + segments + 1;
+
+      mesh.indices.insert(mesh.indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+    }
+  }
+
+  return mesh;
+}
+
+// Shuffles the triangles and the vertices, as an unoptimized importer could output them
+inline void shuffleMesh(TestMesh& mesh, std::mt19937& generator)
+{
+  std::vector<std::array<unsigned int, 3>> triangles(mesh.indices.size() / 3);
+
+  for (size_t i = 0; i < triangles.size(); i++)
+  {
+    triangles[i] = { mesh.indices[i * 3], mesh.indices[i * 3 + 1], mesh.indices[i * 3 + 2] };
+  }
+
+  std::shuffle(triangles.begin(), triangles.end(), generator);
+
+  std::vector<unsigned int> vertexOrder(mesh.vertices.size());
+  std::iota(vertexOrder.begin(), vertexOrder.end(), 0);
+  std::shuffle(vertexOrder.begin(), vertexOrder.end(), generator);
+
+  std::vector<Lotus::MeshVertex> shuffledVertices(mesh.vertices.size());
+
+  for (size_t i = 0; i < vertexOrder.size(); i++)
+  {
+    shuffledVertices[vertexOrder[i]] = mesh.vertices[i];
+  }
+
+  mesh.vertices = shuffledVertices;
+  mesh.indices.clear();
+
+  for (const std::array<unsigned int, 3>& triangle : triangles)
+  {
+    mesh.indices.insert(mesh.indices.end(), { vertexOrder[triangle[0]], vertexOrder[triangle[1]], vertexOrder[triangle[2]] });
+  }
+}
\ No newline at end of file
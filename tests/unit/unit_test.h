@@ -0,0 +1,41 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+/*
+  Minimal checks for the unit tests, each test is an executable whose exit code is reported by CTest
+*/
+class UnitTest
+{
+public:
+
+  UnitTest(const std::string& unitTestName) :
+    name(unitTestName),
+    failures(0)
+  {}
+
+  void expect(bool condition, const std::string& message)
+  {
+    if (!condition)
+    {
+      std::cerr << "[" << name << " Test Failure] " << message << std::endl;
+      failures++;
+    }
+  }
+
+  int result() const
+  {
+    if (failures == 0)
+    {
+      std::cout << "[" << name << " Test] Passed" << std::endl;
+    }
+
+    return failures == 0 ? 0 : 1;
+  }
+
+private:
+
+  std::string name;
+  int failures;
+};
\ No newline at end of file
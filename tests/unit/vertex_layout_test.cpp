@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include "unit_test.h"
+#include "render/vertex_layout.h"
+
+int main()
+{
+  UnitTest test("Vertex Layout");
+
+  std::mt19937 generator(11);
+  std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+
+  test.expect(sizeof(Lotus::CompactVertex) == 20, "Compact vertices take " + std::to_string(sizeof(Lotus::CompactVertex)) + " bytes");
+  test.expect(sizeof(Lotus::MeshVertex) >= 2 * sizeof(Lotus::CompactVertex), "Compact vertices are not at least half the size");
+
+  // Mesh far from the origin and longer along one axis
+  Lotus::AABB aabb;
+  aabb.min = glm::vec3(90.0f, -3.0f, 10.0f);
+  aabb.max = glm::vec3(110.0f, 1.0f, 12.0f);
+
+  const Lotus::VertexQuantization quantization = Lotus::VertexQuantization::fromBounds(aabb);
+
+  test.expect(quantization.offset == glm::vec3(100.0f, -1.0f, 11.0f) && quantization.scale == 10.0f, "Quantization does not map the bounds");
+
+  float positionError = 0.0f;
+  float normalError = 0.0f;
+  float uvError = 0.0f;
+  bool bitangentsMatch = true;
+
+  for (int i = 0; i < 1000; i++)
+  {
+    const glm::vec3 normal = glm::normalize(glm::vec3(unitDistribution(generator), unitDistribution(generator), unitDistribution(generator)));
+    const glm::vec3 tangent = glm::normalize(glm::cross(normal, glm::normalize(glm::vec3(unitDistribution(generator), unitDistribution(generator), unitDistribution(generator)))));
+    const float handedness = i % 2 == 0 ? 1.0f : -1.0f;
+
+    Lotus::MeshVertex vertex;
+    vertex.position = aabb.getCenter() + aabb.getExtents() * glm::vec3(unitDistribution(generator), unitDistribution(generator), unitDistribution(generator));
+    vertex.normal = normal;
+    vertex.uv = glm::vec2(unitDistribution(generator), unitDistribution(generator)) * 4.0f;
+    vertex.tangent = tangent;
+    vertex.bitangent = handedness * glm::cross(normal, tangent);
+
+    const Lotus::MeshVertex decompressed = quantization.decompress(quantization.compress(vertex));
+
+    positionError = std::max(positionError, glm::length(decompressed.position - vertex.position));
+    normalError = std::max(normalError, glm::length(decompressed.normal - vertex.normal));
+    uvError = std::max(uvError, glm::length(decompressed.uv - vertex.uv));
+    bitangentsMatch = bitangentsMatch && glm::dot(decompressed.bitangent, vertex.bitangent) > 0.99f;
+  }
+
+  // Half a snorm16 step on every axis of the largest extent
+  test.expect(positionError <= std::sqrt(3.0f) * 0.5f * quantization.scale / 32767.0f + 1e-5f, "Position error is " + std::to_string(positionError));
+  test.expect(normalError < 1e-3f, "Normal error is " + std::to_string(normalError));
+  test.expect(uvError < 4.0f / 1024.0f, "UV error is " + std::to_string(uvError));
+  test.expect(bitangentsMatch, "Bitangents are not rebuilt with their sign");
+
+  // Folding the dequantization in the model matrix gives the same world positions
+  const glm::mat4 model = glm::mat4(
+      glm::vec4(0.0f, 2.0f, 0.0f, 0.0f),
+      glm::vec4(-2.0f, 0.0f, 0.0f, 0.0f),
+      glm::vec4(0.0f, 0.0f, 2.0f, 0.0f),
+      glm::vec4(5.0f, 6.0f, 7.0f, 1.0f));
+
+  const glm::mat4 quantizedModel = quantization.getModelMatrix(model);
+
+  Lotus::MeshVertex vertex;
+  vertex.position = glm::vec3(95.0f, 0.5f, 11.5f);
+  vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+  vertex.uv = glm::vec2(0.0f);
+  vertex.tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+  vertex.bitangent = glm::vec3(0.0f, 0.0f, -1.0f);
+
+  const Lotus::CompactVertex compactVertex = quantization.compress(vertex);
+  const glm::vec4 quantizedPosition(
+      Lotus::dequantizeSnorm16(compactVertex.position[0]),
+      Lotus::dequantizeSnorm16(compactVertex.position[1]),
+      Lotus::dequantizeSnorm16(compactVertex.position[2]),
+      1.0f);
+
+  const glm::vec3 worldPosition = glm::vec3(model * glm::vec4(vertex.position, 1.0f));
+  const glm::vec3 quantizedWorldPosition = glm::vec3(quantizedModel * quantizedPosition);
+
+  test.expect(glm::length(worldPosition - quantizedWorldPosition) < 1e-3f, "Dequantizing model matrix moves the vertex by " + std::to_string(glm::length(worldPosition - quantizedWorldPosition)));
+
+  // Degenerate bounds keep the identity mapping
+  const Lotus::VertexQuantization emptyQuantization = Lotus::VertexQuantization::fromBounds(Lotus::AABB());
+
+  test.expect(emptyQuantization.offset == glm::vec3(0.0f) && emptyQuantization.scale == 1.0f, "Empty bounds are not the identity mapping");
+
+  return test.result();
+}
\ No newline at end of file
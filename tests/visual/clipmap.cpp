@@ -77,10 +77,12 @@ int main()
 
 	Lotus::Camera camera;
 
+  Lotus::ThreadPool threadPool;
+
   Lotus::PerlinNoiseConfig noiseConfiguration;
-  std::shared_ptr<Lotus::ProceduralDataGenerator> dataGenerator = std::make_shared<Lotus::ProceduralDataGenerator>(512, 6, noiseConfiguration);
+  std::shared_ptr<Lotus::ProceduralDataGenerator> dataGenerator = std::make_shared<Lotus::ProceduralDataGenerator>(threadPool, 512, 6, noiseConfiguration);
 
-  Lotus::RenderingServer renderingServer;
+  Lotus::RenderingServer renderingServer(threadPool);
 
   renderingServer.setRenderingMode(Lotus::RenderingMode::Wireframe);
 